@@ -0,0 +1,358 @@
+// Benchmark to measure how the Timer Manager APIs scale with the number of Application Threads
+// A ticker thread drives the Virtual Clock as fast as it can so expiries run at full rate
+// while 1 to N worker threads call RTOSTmrCreate/RTOSTmrStart/RTOSTmrStop/RTOSTmrDel
+// Build with "make bench", TimerAPI.c is compiled with RTOS_CFG_LOCK_STATS for the lock breakdown
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include "TypeDefines.h"
+#include "TimerMgrHeader.h"
+#include "TimerAPI.h"
+
+#define BENCH_MAX_THREADS	64
+#define BENCH_SLOTS_PER_THREAD	256
+
+// Operations in the workload mix
+#define BENCH_OP_CREATE		0
+#define BENCH_OP_START		1
+#define BENCH_OP_STOP		2
+#define BENCH_OP_DEL		3
+#define BENCH_OPS		4
+
+// Ticks to run after the workers stop so every armed One Shot Timer gets to fire
+#define BENCH_DRAIN_TICKS	100
+
+// One Timer handle owned by a worker thread
+// Each arming is told apart by its Match tick, on the Virtual Clock a One Shot Timer fires exactly on it
+// and restarting moves it at least one Delay later, so two armings that can still fire never share one
+typedef struct bench_slot {
+	RTOS_TMR	*timer;
+	INT32U	armed_match;	/* Match tick of the last start, owner thread only */
+	INT32U	fired_match;	/* Tick of the last Callback, updated from the ticker thread */
+	INT32U	double_fired;	/* Callbacks that ran twice on the same tick, i.e. twice for one arming */
+	INT32U	lost;	/* Armings whose Match tick went by without a Callback, owner thread only */
+	INT8U	armed;	/* Last operation was a start */
+} BENCH_SLOT;
+
+// Worker Thread State
+typedef struct bench_worker {
+	pthread_t	thread;
+	unsigned int	seed;
+	INT64U	ops[BENCH_OPS];
+	BENCH_SLOT	slot[BENCH_SLOTS_PER_THREAD];
+} BENCH_WORKER;
+
+// Benchmark Settings
+INT32U bench_max_threads = BENCH_MAX_THREADS;
+INT32U bench_duration_ms = 1000;
+INT32U bench_pool_size = 65536;
+INT32U bench_background = 1000;
+INT32U bench_weight[BENCH_OPS] = {10, 40, 40, 10};
+
+// Shared Benchmark State
+BENCH_WORKER bench_worker[BENCH_MAX_THREADS];
+volatile int bench_workers_stop;
+volatile int bench_ticker_stop;
+INT64U bench_ticks;
+INT64U bench_expiries;
+INT64U bench_live;
+
+extern RTOS_TMR_CTRL *RTOSTmrCtrl;
+
+// Callback for the worker Timers, runs on the ticker thread so the tick cannot move meanwhile
+void bench_callback(void *arg)
+{
+	BENCH_SLOT *slot = arg;
+	INT32U tick = RTOSTmrTickGet();
+
+	if (__atomic_exchange_n(&slot->fired_match, tick, __ATOMIC_RELAXED) == tick)
+		__atomic_add_fetch(&slot->double_fired, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&bench_expiries, 1, __ATOMIC_RELAXED);
+}
+
+// Callback for the background Periodic Timers
+void bench_background_callback(void *arg)
+{
+	__atomic_add_fetch(&bench_expiries, 1, __ATOMIC_RELAXED);
+}
+
+// Ticker Thread, advances the Virtual Clock at full rate
+void *bench_ticker(void *arg)
+{
+	INT8U err;
+
+	while (!bench_ticker_stop) {
+		RTOSTmrAdvance(1, &err);
+		__atomic_add_fetch(&bench_ticks, 1, __ATOMIC_RELAXED);
+	}
+	return arg;
+}
+
+// Pick an operation according to the workload mix
+INT8U bench_pick_op(unsigned int *seed)
+{
+	INT32U total = 0;
+	INT32U r;
+	INT8U op;
+
+	for (op = 0; op < BENCH_OPS; op++)
+		total += bench_weight[op];
+	r = rand_r(seed) % total;
+	for (op = 0; op < BENCH_OPS - 1; op++) {
+		if (r < bench_weight[op])
+			break;
+		r -= bench_weight[op];
+	}
+	return op;
+}
+
+// Worker Thread, runs the workload mix on its own slots until told to stop
+void *bench_worker_task(void *arg)
+{
+	BENCH_WORKER *worker = arg;
+	BENCH_SLOT *slot;
+	INT8U err;
+	INT8U op;
+
+	while (!bench_workers_stop) {
+		slot = &worker->slot[rand_r(&worker->seed) % BENCH_SLOTS_PER_THREAD];
+		op = bench_pick_op(&worker->seed);
+
+		// Operations on a slot without a Timer create one instead
+		if (slot->timer == NULL)
+			op = BENCH_OP_CREATE;
+		else if (op == BENCH_OP_CREATE)
+			op = BENCH_OP_START;
+
+		// The arming about to be replaced must have fired if its Match tick is over,
+		// the ticker runs the Callbacks of a tick before moving on to the next one
+		if (slot->armed && RTOS_TMR_TICK_REACHED(slot->armed_match + 1, RTOSTmrTickGet()) &&
+		    __atomic_load_n(&slot->fired_match, __ATOMIC_ACQUIRE) != slot->armed_match)
+			slot->lost++;
+
+		switch (op) {
+		case BENCH_OP_CREATE:
+			slot->timer = RTOSTmrCreate(1 + rand_r(&worker->seed) % 3, 0, RTOS_TMR_ONE_SHOT, bench_callback, slot, NULL, &err);
+			if (slot->timer == NULL)
+				continue;
+			__atomic_add_fetch(&bench_live, 1, __ATOMIC_RELAXED);
+			break;
+		case BENCH_OP_START:
+			RTOSTmrStart(slot->timer, &err);
+			// Only this thread starts the Timer and the Timer Task never moves a One Shot Match
+			slot->armed_match = __atomic_load_n(&slot->timer->RTOSTmrMatch, __ATOMIC_RELAXED);
+			slot->armed = RTOS_TRUE;
+			break;
+		case BENCH_OP_STOP:
+			RTOSTmrStop(slot->timer, RTOS_TMR_OPT_NONE, NULL, &err);
+			slot->armed = RTOS_FALSE;
+			break;
+		case BENCH_OP_DEL:
+			RTOSTmrDel(slot->timer, &err);
+			slot->timer = NULL;
+			slot->armed = RTOS_FALSE;
+			__atomic_sub_fetch(&bench_live, 1, __ATOMIC_RELAXED);
+			break;
+		}
+		worker->ops[op]++;
+	}
+	return arg;
+}
+
+// Check the invariants once the workers have stopped and the armed Timers had time to fire
+// Returns the number of violations found
+INT32U bench_verify(INT32U threads)
+{
+	BENCH_SLOT *slot;
+	INT32U lost = 0;
+	INT32U double_fired = 0;
+	INT32U free_count;
+	INT32U i, j;
+
+	for (i = 0; i < threads; i++) {
+		for (j = 0; j < BENCH_SLOTS_PER_THREAD; j++) {
+			slot = &bench_worker[i].slot[j];
+			// A One Shot Timer fires at most once per arming
+			double_fired += slot->double_fired;
+			// Every arming that was not replaced before its Match tick must have fired on it
+			lost += slot->lost;
+			if (slot->armed && slot->fired_match != slot->armed_match)
+				lost++;
+		}
+	}
+
+	// Every Timer is either free in the pool or held by a worker or the background set
+	pthread_mutex_lock(&RTOSTmrCtrl->timer_pool_mutex);
+	free_count = RTOSTmrCtrl->FreeTmrCount;
+	pthread_mutex_unlock(&RTOSTmrCtrl->timer_pool_mutex);
+
+	if (lost)
+		fprintf(stdout, "  FAIL: %u armings never fired\n", lost);
+	if (double_fired)
+		fprintf(stdout, "  FAIL: %u armings fired more than once\n", double_fired);
+	if (free_count + bench_live + bench_background != bench_pool_size)
+		fprintf(stdout, "  FAIL: pool count %u free + %llu live + %u background != %u\n",
+			free_count, bench_live, bench_background, bench_pool_size);
+
+	return lost + double_fired + (free_count + bench_live + bench_background != bench_pool_size);
+}
+
+// Delete the worker Timers so the next step starts from a full pool
+void bench_cleanup(INT32U threads)
+{
+	INT32U i, j;
+	INT8U err;
+
+	for (i = 0; i < threads; i++) {
+		for (j = 0; j < BENCH_SLOTS_PER_THREAD; j++) {
+			if (bench_worker[i].slot[j].timer != NULL) {
+				RTOSTmrDel(bench_worker[i].slot[j].timer, &err);
+				bench_live--;
+			}
+		}
+		memset(&bench_worker[i], 0, sizeof(BENCH_WORKER));
+	}
+}
+
+// Print the average of a total over a count, or 0
+double bench_avg(INT64U total, INT64U count)
+{
+	return count ? (double)total / count : 0;
+}
+
+// Run one step of the benchmark with the given number of worker threads
+INT32U bench_run(INT32U threads)
+{
+	RTOS_LOCK_STATS hash_stats, pool_stats;
+	struct timespec start, end;
+	INT64U ops[BENCH_OPS] = {0};
+	INT64U total = 0;
+	INT64U ticks, expiries;
+	double secs;
+	INT32U i, op;
+
+	RTOSTmrLockStatsReset();
+	__atomic_store_n(&bench_expiries, 0, __ATOMIC_RELAXED);
+	ticks = __atomic_load_n(&bench_ticks, __ATOMIC_RELAXED);
+	bench_workers_stop = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < threads; i++) {
+		bench_worker[i].seed = i + 1;
+		pthread_create(&bench_worker[i].thread, NULL, bench_worker_task, &bench_worker[i]);
+	}
+
+	usleep(bench_duration_ms * 1000);
+	bench_workers_stop = 1;
+	for (i = 0; i < threads; i++)
+		pthread_join(bench_worker[i].thread, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	ticks = __atomic_load_n(&bench_ticks, __ATOMIC_RELAXED) - ticks;
+	expiries = __atomic_load_n(&bench_expiries, __ATOMIC_RELAXED);
+	RTOSTmrLockStatsGet(&hash_stats, &pool_stats);
+
+	for (i = 0; i < threads; i++) {
+		for (op = 0; op < BENCH_OPS; op++) {
+			ops[op] += bench_worker[i].ops[op];
+			total += bench_worker[i].ops[op];
+		}
+	}
+
+	fprintf(stdout, "%7u %11.0f %10.0f %10.0f %10.0f %10.0f %10.0f %9.0f | %6.1f%% %8.0f %7.0f | %6.1f%% %8.0f %7.0f\n",
+		threads, total / secs,
+		ops[BENCH_OP_CREATE] / secs, ops[BENCH_OP_START] / secs, ops[BENCH_OP_STOP] / secs, ops[BENCH_OP_DEL] / secs,
+		expiries / secs, ticks / secs,
+		100 * bench_avg(hash_stats.contended, hash_stats.acquired),
+		bench_avg(hash_stats.wait_ns, hash_stats.contended), bench_avg(hash_stats.hold_ns, hash_stats.acquired),
+		100 * bench_avg(pool_stats.contended, pool_stats.acquired),
+		bench_avg(pool_stats.wait_ns, pool_stats.contended), bench_avg(pool_stats.hold_ns, pool_stats.acquired));
+
+	// Let every armed Timer expire before checking
+	ticks = __atomic_load_n(&bench_ticks, __ATOMIC_RELAXED);
+	while (__atomic_load_n(&bench_ticks, __ATOMIC_RELAXED) - ticks < BENCH_DRAIN_TICKS)
+		usleep(1000);
+
+	i = bench_verify(threads);
+	bench_cleanup(threads);
+	return i;
+}
+
+void bench_usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-t max_threads] [-d ms_per_step] [-p pool_size] [-b background_timers] [-m create:start:stop:del]\n", prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	RTOS_TMR *timer_obj;
+	pthread_t ticker;
+	INT32U failures = 0;
+	INT32U threads;
+	INT32U i;
+	INT8U err;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "t:d:p:b:m:")) != -1) {
+		switch (opt) {
+		case 't':
+			bench_max_threads = atoi(optarg);
+			break;
+		case 'd':
+			bench_duration_ms = atoi(optarg);
+			break;
+		case 'p':
+			bench_pool_size = atoi(optarg);
+			break;
+		case 'b':
+			bench_background = atoi(optarg);
+			break;
+		case 'm':
+			if (sscanf(optarg, "%u:%u:%u:%u", &bench_weight[0], &bench_weight[1], &bench_weight[2], &bench_weight[3]) != 4)
+				bench_usage(argv[0]);
+			break;
+		default:
+			bench_usage(argv[0]);
+		}
+	}
+	if (bench_max_threads < 1 || bench_max_threads > BENCH_MAX_THREADS ||
+	    bench_weight[0] + bench_weight[1] + bench_weight[2] + bench_weight[3] == 0 ||
+	    bench_pool_size < bench_background + bench_max_threads * BENCH_SLOTS_PER_THREAD)
+		bench_usage(argv[0]);
+
+	if (!RTOSTmrInitVirtual(bench_pool_size, &err)) {
+		fprintf(stderr, "Error creating the timer pool - %d\n", err);
+		return 1;
+	}
+
+	// Background Periodic Timers keep the Timer Task busy expiring
+	for (i = 0; i < bench_background; i++) {
+		timer_obj = RTOSTmrCreate(0, 1 + i % 5, RTOS_TMR_PERIODIC, bench_background_callback, NULL, NULL, &err);
+		RTOSTmrStart(timer_obj, &err);
+	}
+	pthread_create(&ticker, NULL, bench_ticker, NULL);
+
+	fprintf(stdout, "Mix create:start:stop:del = %u:%u:%u:%u, %u ms per step, pool %u, %u background timers\n",
+		bench_weight[0], bench_weight[1], bench_weight[2], bench_weight[3], bench_duration_ms, bench_pool_size, bench_background);
+	fprintf(stdout, "%7s %11s %10s %10s %10s %10s %10s %9s | %-24s | %-24s\n",
+		"threads", "ops/s", "create/s", "start/s", "stop/s", "del/s", "expiry/s", "ticks/s",
+		"hash_table_mutex", "timer_pool_mutex");
+	fprintf(stdout, "%7s %11s %10s %10s %10s %10s %10s %9s | %7s %8s %7s | %7s %8s %7s\n",
+		"", "", "", "", "", "", "", "", "cont", "wait_ns", "hold_ns", "cont", "wait_ns", "hold_ns");
+
+	for (threads = 1; threads <= bench_max_threads; threads *= 2)
+		failures += bench_run(threads);
+	if ((bench_max_threads & (bench_max_threads - 1)) != 0)
+		failures += bench_run(bench_max_threads);
+
+	bench_ticker_stop = 1;
+	pthread_join(ticker, NULL);
+
+	fprintf(stdout, "%s\n", failures ? "Invariant check FAILED" : "Invariant check passed");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,229 @@
+// Determinism check for the Virtual Clock
+// The same seeded trace of Timer operations is replayed in separate processes and the expiries seen by each run
+// are compared, so the Virtual Clock must give the same Callbacks on the same ticks in the same order every time
+// Two runs advance the clock in chunks, letting RTOSTmrAdvance() jump over idle stretches, and one steps it a tick
+// at a time, so the jump must not change the result either
+// Build with "make replay"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/wait.h>
+#include "TypeDefines.h"
+#include "TimerMgrHeader.h"
+#include "TimerAPI.h"
+
+#define REPLAY_TIMERS		2000
+#define REPLAY_RUNS		3
+
+// Ticks of simulated time, a busy first hour then a sparse rest of the day
+#define REPLAY_BUSY_TICKS	36000
+#define REPLAY_TICKS		864000
+
+// Largest chunk the driver advances the clock by between two of its operations
+#define REPLAY_CHUNK_BUSY	50
+#define REPLAY_CHUNK_SPARSE	20000
+
+// Result of one run, sent back to the parent through a pipe
+typedef struct replay_result {
+	INT64U	expiries;
+	INT64U	hash;	/* FNV-1a over the tick and Timer of every expiry in order */
+	INT32U	tick;
+	INT8U	err;
+	double	seconds;
+} REPLAY_RESULT;
+
+// Replay Settings
+unsigned int replay_seed = 1;
+
+// State of the run in progress
+RTOS_TMR *replay_timer[REPLAY_TIMERS];
+REPLAY_RESULT replay_result;
+unsigned int replay_callback_seed;
+
+void replay_callback(void *arg);
+
+// Random number from the state given, the same sequence on every run
+INT32U replay_rand(unsigned int *state)
+{
+	*state = *state * 1103515245 + 12345;
+	return (*state >> 16) & 0x7FFF;
+}
+
+// Delete the Timer of a slot and create a new one, short ones during the busy hour and long ones after it
+void replay_replace(INT32U slot, unsigned int *state, INT8U sparse)
+{
+	INT32U delay, period;
+	INT8U err;
+
+	if (replay_timer[slot] != NULL)
+		RTOSTmrDel(replay_timer[slot], &err);
+
+	if (!sparse) {
+		delay = replay_rand(state) % 60;
+		period = replay_rand(state) % 2 ? 1 + replay_rand(state) % 30 : 0;
+	}
+	else {
+		delay = 600 + replay_rand(state) % 7200;
+		period = replay_rand(state) % 8 ? 0 : 3600 + replay_rand(state) % 3600;
+	}
+	if (period == 0 && delay == 0)
+		delay = 1;
+
+	replay_timer[slot] = RTOSTmrCreate(delay, period, period ? RTOS_TMR_PERIODIC : RTOS_TMR_ONE_SHOT,
+		replay_callback, (void *)(unsigned long)slot, NULL, &err);
+	if (replay_timer[slot] != NULL)
+		RTOSTmrStart(replay_timer[slot], &err);
+}
+
+// Callback for every Timer, records the expiry and now and then restarts or stops another Timer
+void replay_callback(void *arg)
+{
+	INT32U slot = (INT32U)(unsigned long)arg;
+	INT32U tick = RTOSTmrTickGet();
+	INT32U other;
+	INT8U err;
+
+	replay_result.hash = (replay_result.hash ^ tick) * 1099511628211ULL;
+	replay_result.hash = (replay_result.hash ^ slot) * 1099511628211ULL;
+	replay_result.expiries++;
+
+	if (replay_rand(&replay_callback_seed) % 16 == 0) {
+		other = replay_rand(&replay_callback_seed) % REPLAY_TIMERS;
+		if (replay_timer[other] == NULL)
+			return;
+		if (replay_rand(&replay_callback_seed) % 2)
+			RTOSTmrStart(replay_timer[other], &err);
+		else
+			RTOSTmrStop(replay_timer[other], RTOS_TMR_OPT_NONE, NULL, &err);
+	}
+}
+
+// Replay the trace, stepping the clock a tick at a time or in chunks
+void replay_run(INT8U stepped)
+{
+	unsigned int driver_seed = replay_seed;
+	struct timespec start, end;
+	INT32U target, chunk, slot;
+	INT8U sparse;
+	INT8U err;
+
+	replay_callback_seed = replay_seed ^ 0x5A5A5A5A;
+	replay_result.hash = 14695981039346656037ULL;
+
+	if (!RTOSTmrInitVirtual(REPLAY_TIMERS, &err)) {
+		replay_result.err = err;
+		return;
+	}
+	for (slot = 0; slot < REPLAY_TIMERS; slot++)
+		replay_replace(slot, &driver_seed, RTOS_FALSE);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	while (RTOSTmrTickGet() < REPLAY_TICKS) {
+		sparse = RTOSTmrTickGet() >= REPLAY_BUSY_TICKS;
+		chunk = 1 + replay_rand(&driver_seed) % (sparse ? REPLAY_CHUNK_SPARSE : REPLAY_CHUNK_BUSY);
+		target = RTOSTmrTickGet() + chunk;
+		if (target > REPLAY_TICKS)
+			target = REPLAY_TICKS;
+
+		if (stepped) {
+			while (RTOSTmrTickGet() < target)
+				RTOSTmrAdvance(1, &err);
+		}
+		else {
+			RTOSTmrRunUntil(target, &err);
+		}
+
+		// The busy hour is over, every Timer is replaced by a long one
+		if (!sparse && RTOSTmrTickGet() >= REPLAY_BUSY_TICKS) {
+			for (slot = 0; slot < REPLAY_TIMERS; slot++)
+				replay_replace(slot, &driver_seed, RTOS_TRUE);
+		}
+		// Otherwise replace one Timer
+		else {
+			slot = replay_rand(&driver_seed) % REPLAY_TIMERS;
+			replay_replace(slot, &driver_seed, sparse);
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	replay_result.tick = RTOSTmrTickGet();
+	replay_result.seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Run the replay in a child process, the Timer Manager can only be set up once per process
+INT8U replay_fork(INT8U stepped, REPLAY_RESULT *result)
+{
+	int fd[2];
+	int status;
+	pid_t pid;
+
+	if (pipe(fd) != 0)
+		return RTOS_FALSE;
+
+	pid = fork();
+	if (pid == 0) {
+		close(fd[0]);
+		replay_run(stepped);
+		_exit(write(fd[1], &replay_result, sizeof(replay_result)) == sizeof(replay_result) ? 0 : 1);
+	}
+	close(fd[1]);
+	if (pid < 0 || read(fd[0], result, sizeof(*result)) != sizeof(*result)) {
+		close(fd[0]);
+		return RTOS_FALSE;
+	}
+	close(fd[0]);
+	waitpid(pid, &status, 0);
+
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+void replay_usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-s seed]\n", prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	REPLAY_RESULT result[REPLAY_RUNS];
+	INT32U failures = 0;
+	INT32U run;
+	INT8U stepped;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "s:")) != -1) {
+		switch (opt) {
+		case 's':
+			replay_seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			replay_usage(argv[0]);
+		}
+	}
+
+	fprintf(stdout, "Seed %u, %u timers, %u ticks\n", replay_seed, REPLAY_TIMERS, REPLAY_TICKS);
+
+	for (run = 0; run < REPLAY_RUNS; run++) {
+		// The last run steps one tick at a time
+		stepped = run == REPLAY_RUNS - 1;
+		memset(&result[run], 0, sizeof(result[run]));
+		if (!replay_fork(stepped, &result[run]) || result[run].err != RTOS_ERR_NONE) {
+			fprintf(stdout, "Run %u failed - %d\n", run + 1, result[run].err);
+			failures++;
+			continue;
+		}
+		fprintf(stdout, "Run %u %-8s %10llu expiries, hash %016llx, tick %u, %.3f s\n", run + 1,
+			stepped ? "stepped" : "chunked", (unsigned long long)result[run].expiries,
+			(unsigned long long)result[run].hash, result[run].tick, result[run].seconds);
+		if (run > 0 && (result[run].expiries != result[0].expiries || result[run].hash != result[0].hash ||
+		    result[run].tick != result[0].tick))
+			failures++;
+	}
+
+	fprintf(stdout, "%s\n", failures ? "Determinism check FAILED" : "Determinism check passed");
+	return failures ? 1 : 0;
+}
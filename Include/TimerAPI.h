@@ -8,12 +8,22 @@
 #include "TypeDefines.h"
 
 // Thread variable for Timer Task
-pthread_t thread;
+extern pthread_t thread;
 
 // TIMER MANAGER APIs
 
 extern void RTOSTmrInit(void);
 
+extern INT8U RTOSTmrInitVirtual(INT32U timer_count, INT8U *perr);
+
+extern INT8U RTOSTmrAdvance(INT32U ticks, INT8U *perr);
+
+extern INT8U RTOSTmrRunUntil(INT32U deadline, INT8U *perr);
+
+extern INT32U RTOSTmrTickGet(void);
+
+// At most RTOS_CFG_TMR_CALLBACKS - 1 different Callback Functions can be in use in a process,
+// past that RTOSTmrCreate() fails with RTOS_ERR_TMR_CALLBACK_FULL
 extern RTOS_TMR* RTOSTmrCreate(INT32U delay, INT32U period, INT8U option, RTOS_TMR_CALLBACK callback, void *callback_arg, INT8	*name, INT8U *err);
 
 extern INT8U RTOSTmrDel(RTOS_TMR *ptmr, INT8U *perr);
@@ -30,21 +40,95 @@ extern INT8U RTOSTmrStop(RTOS_TMR *ptmr, INT8U opt, void *callback_arg, INT8U *p
 
 extern void RTOSTmrSignal(int signum);
 
+extern INT8U RTOSTmrPrioSet(RTOS_TMR *ptmr, INT8U prio, INT8U *perr);
+
+extern INT8U RTOSTmrBudgetSet(INT8U mode, INT32U limit, INT8U *perr);
+
+extern void RTOSTmrStatsGet(RTOS_TMR_STATS *stats);
+
+extern INT8U RTOSTmrOverrunSet(RTOS_TMR *ptmr, INT8U policy, INT8U *perr);
+
+extern INT32U RTOSTmrMissedGet(RTOS_TMR *ptmr, INT8U *perr);
+
+extern INT8U RTOSTmrCallbackRegister(INT32U callback_id, RTOS_TMR_CALLBACK callback, INT8U *perr);
+
+extern INT32U RTOSTmrSnapshotSave(const char *path, INT8U *perr);
+
+extern INT32U RTOSTmrSnapshotRestore(const char *path, INT8U *perr);
+
+extern INT8U RTOSTmrShmServiceInit(const char *name, INT32U timer_count, INT8U *perr);
+
+// A client that exits without RTOSTmrShmDetach() keeps its slot and Timers until the next RTOSTmrShmAttach(),
+// which finds its process gone, deletes the Timers it owned and gives the slot back
+extern INT8U RTOSTmrShmAttach(const char *name, INT8U *perr);
+
+extern INT32U RTOSTmrShmDispatch(INT32U timeout_ms, INT8U *perr);
+
+extern INT8U RTOSTmrShmDetach(INT8U *perr);
+
+extern void RTOSTmrLockStatsGet(RTOS_LOCK_STATS *hash_stats, RTOS_LOCK_STATS *pool_stats);
+
+extern void RTOSTmrLockStatsReset(void);
+
+extern void RTOSTmrIterInit(RTOS_TMR_ITER *iter);
+
+extern INT8U RTOSTmrIterNext(RTOS_TMR_ITER *iter, RTOS_TMR_INFO *info);
+
+extern INT8U RTOSTmrNameIndexEnable(INT8U *perr);
+
+extern RTOS_TMR* RTOSTmrFindByName(INT8 *name, INT8U *perr);
+
+extern INT8U RTOSTmrWatchdogSet(INT32U threshold_us, INT8U strikes, RTOS_TMR_WATCHDOG_HOOK hook, INT8U *perr);
+
+extern INT8U RTOSTmrStrikesClear(RTOS_TMR *ptmr, INT8U *perr);
+
 // Internal Functions
+INT8U init_timer_engine(INT32U timer_count, int pshared);
+
 INT8U Create_Timer_Pool(INT32U timer_count);
 
 void init_hash_table(void);
 
+void init_ready_queues(void);
+
 void insert_hash_entry(RTOS_TMR *timer_obj);
 
 void remove_hash_entry(RTOS_TMR *timer_obj);
 
+void insert_ready_entry(RTOS_TMR *timer_obj);
+
+void remove_ready_entry(RTOS_TMR *timer_obj);
+
+INT32U expire_hash_entries(void);
+
+void dispatch_ready_timers(void);
+
+void rearm_periodic_timer(RTOS_TMR *timer_obj);
+
+INT32U process_tick(void);
+
+INT8U post_shm_expiry(RTOS_TMR *timer_obj);
+
+void insert_name_entry(RTOS_TMR *timer_obj);
+
+void remove_name_entry(RTOS_TMR *timer_obj);
+
 void* RTOSTmrTask(void *temp);
 
+void* RTOSTmrQuarantineTask(void *temp);
+
+void run_ready_timer(RTOS_TMR *timer_obj, INT32U *wake_mask);
+
+void wake_shm_clients(INT32U wake_mask);
+
+void reclaim_shm_client(INT32U client);
+
 RTOS_TMR* alloc_timer_obj(void);
 
 void free_timer_obj(RTOS_TMR *ptmr);
 
+INT16U register_callback(RTOS_TMR_CALLBACK callback);
+
 void OSTickInitialize(void);
 
 #endif
@@ -2,6 +2,8 @@
 #ifndef TIMER_MGR_HEADER
 #define TIMER_MGR_HEADER
 
+#include <pthread.h>
+
 #include "TypeDefines.h"
 
 // OS Tick Time in ns
@@ -38,27 +40,98 @@
 #define RTOS_ERR_TMR_INVALID		9
 #define RTOS_ERR_TMR_STOPPED		10
 #define RTOS_ERR_TMR_NO_CALLBACK	11
+#define RTOS_ERR_TMR_INVALID_PRIO	12
+#define RTOS_ERR_TMR_INVALID_BUDGET	13
+#define RTOS_ERR_TMR_CALLBACK_FULL	14
+#define RTOS_ERR_TMR_NOT_VIRTUAL	15
+#define RTOS_ERR_TMR_SNAP_IO		16
+#define RTOS_ERR_TMR_SNAP_FORMAT	17
+#define RTOS_ERR_TMR_SHM		18
+#define RTOS_ERR_TMR_SHM_FULL		19
+#define RTOS_ERR_TMR_NOT_CLIENT		20
+#define RTOS_ERR_TMR_NOT_FOUND		21
+#define RTOS_ERR_TMR_WATCHDOG		22
+#define RTOS_ERR_TMR_NOT_OWNER		23
+#define RTOS_ERR_TMR_SHM_DROPPED	24
+
+// RTOS Periodic Overrun Policies, what to do with periods missed while the Timer waited for dispatch
+#define RTOS_TMR_OVERRUN_BURST		1	/* Call back once per missed period to catch up */
+#define RTOS_TMR_OVERRUN_SKIP		2	/* Drop the missed periods and stay on the cadence */
+#define RTOS_TMR_OVERRUN_COALESCE	3	/* One call, missed periods available from RTOSTmrMissedGet() */
 
 // RTOS Stop Options
 #define RTOS_TMR_OPT_NONE		1
 #define RTOS_TMR_OPT_CALLBACK		2
 #define RTOS_TMR_OPT_CALLBACK_ARG	3
 
+// RTOS Timer Priorities, High Priority Timers are never deferred by the budget
+#define RTOS_TMR_PRIO_HIGH		0
+#define RTOS_TMR_PRIO_NORMAL		1
+#define RTOS_TMR_PRIO_LOW		2
+#define RTOS_TMR_PRIO_LEVELS		3
+
+// RTOS Per-Tick Budget Modes
+#define RTOS_TMR_BUDGET_NONE		1
+#define RTOS_TMR_BUDGET_COUNT		2
+#define RTOS_TMR_BUDGET_USEC		3
+
+// RTOS Clock Sources
+#define RTOS_TMR_CLOCK_REAL		1	/* SIGALRM tick feeding RTOSTmrSignal() */
+#define RTOS_TMR_CLOCK_VIRTUAL		2	/* Application advances time with RTOSTmrAdvance() */
+
+// RTOS Timer Queues, tells which list is currently holding a Timer
+#define RTOS_TMR_QUEUE_NONE		0
+#define RTOS_TMR_QUEUE_WHEEL		1
+#define RTOS_TMR_QUEUE_READY		2
+#define RTOS_TMR_QUEUE_QUARANTINE	3
+
 #define HASH_TABLE_SIZE		10
 
+// Number of distinct Callback Functions a process can use, entry 0 is kept for no Callback
+// Timers keep a 16 bit index, so it can be raised at build time to any power of two up to 65536
+#ifndef RTOS_CFG_TMR_CALLBACKS
+#define RTOS_CFG_TMR_CALLBACKS	4096
+#endif
+#if RTOS_CFG_TMR_CALLBACKS > 65536 || (RTOS_CFG_TMR_CALLBACKS & (RTOS_CFG_TMR_CALLBACKS - 1)) != 0
+#error "RTOS_CFG_TMR_CALLBACKS must be a power of two no larger than 65536"
+#endif
+
+// Slots of the hash used to find a Callback Function's index, kept at most half full
+#define RTOS_CFG_TMR_CALLBACK_HASH	(2 * RTOS_CFG_TMR_CALLBACKS)
+
+// Least time between two Callback Watchdog reports printed when no hook is given, in ns
+#define RTOS_CFG_TMR_WATCHDOG_PRINT_NS	1000000000ULL
+
+// Shared Memory Timer Service, client processes and expiry notifications each client can have queued
+#define RTOS_CFG_SHM_CLIENTS		8
+#define RTOS_CFG_SHM_RING		4096
+#define RTOS_TMR_SHM_MAGIC		0x4D485354
+
+// Owner of Timers created by the process running the Timer Task, clients are 1 to RTOS_CFG_SHM_CLIENTS
+#define RTOS_TMR_OWNER_SERVICE		0
+
+// Snapshot File identification and number of Timers copied per hold of hash_table_mutex
+#define RTOS_TMR_SNAP_MAGIC		0x524D5453
+#define RTOS_TMR_SNAP_VERSION		2
+#define RTOS_CFG_TMR_SNAP_CHUNK		4096
+
+// End of List marker for the Slab Index links
+#define RTOS_TMR_NIL	0xFFFFFFFF
+
+// True once the Tick Counter has reached the Match value, safe across wrap around
+#define RTOS_TMR_TICK_REACHED(match, tick)	((INT32)((tick) - (match)) >= 0)
+
 // Timer Callback
 typedef void (*RTOS_TMR_CALLBACK)(void *p_arg);
 
 // OS Timer Object Structure
+// Timers live in one slab allocated by Create_Timer_Pool() and link to each other by slab index,
+// callbacks are kept in a small per-process table and names in an optional side table, so a record is 48 bytes
 typedef struct os_timer {
-	INT8U	RTOSTmrType;	/* Should Always be set to RTOS_TMR_TYPE for Timers*/
-
-	RTOS_TMR_CALLBACK	RTOSTmrCallback;	/* Function to call when Timer Expires */
-
 	void	*RTOSTmrCallbackArg;	/* Callback Function Arguments */
 
-	struct os_timer	*RTOSTmrNext;	/* Double Link List Pointers */
-	struct os_timer	*RTOSTmrPrev;
+	INT32U	RTOSTmrNext;	/* Double Link List Slab Indexes, RTOS_TMR_NIL ends the list */
+	INT32U	RTOSTmrPrev;
 
 	INT32U	RTOSTmrMatch;	/* Timer Expires when RTOSTmrTickCtr = RTOSTmrMatch */
 
@@ -66,21 +139,161 @@ typedef struct os_timer {
 
 	INT32U	RTOSTmrPeriod;	/* Period to repeat Timer*/
 
-	INT8	*RTOSTmrName;	/* Name to give to the Timer */
+	INT32U	RTOSTmrMissed;	/* Periods coalesced into the current Callback */
+
+	INT32U	RTOSTmrSeq;	/* Bumped before and after every change, lets RTOSTmrIterNext() read without locking */
+
+	INT16U	RTOSTmrCallbackId;	/* Function to call when Timer Expires, index in the owner's Callback Table */
+
+	INT8U	RTOSTmrOwner;	/* Process the Callback runs in, RTOS_TMR_OWNER_SERVICE or a Shared Memory client */
+
+	INT8U	RTOSTmrType;	/* Should Always be set to RTOS_TMR_TYPE for Timers*/
 
 	INT8U	RTOSTmrOpt;	/* Timer Options */
 
+	INT8U	RTOSTmrPrio;	/* Dispatch Priority, RTOS_TMR_PRIO_HIGH runs first */
+
+	INT8U	RTOSTmrOverrun;	/* Periodic Overrun Policy, RTOS_TMR_OVERRUN_xxx */
+
+	INT8U	RTOSTmrQueue;	/* List holding the Timer, RTOS_TMR_QUEUE_xxx */
+
+	INT8U	RTOSTmrStrikes;	/* Callbacks that ran past the watchdog threshold, saturates at 255 */
+
 	INT8U	RTOSTmrState;	/* State of the Timer
 				   RTOS_TMR_STATE_UNUSED
 				   RTOS_TMR_STATE_STOPPED
 				   RTOS_TMR_STATE_RUNNING
 				   RTOS_TMR_STATE_COMPLETED	*/
+
+	INT16U	RTOSTmrGen;	/* Bumped when the record is allocated or freed, tells a reused record from the Timer it held */
 } RTOS_TMR;
 
 // Hash Table Entry Structure
 typedef struct hash_obj {
-	INT8U	timer_count;
-	RTOS_TMR *list_ptr;
+	INT32U	timer_count;
+	INT32U	list_idx;
+	INT32U	tail_idx;
 } HASH_OBJ;
 
+// Ready Queue Structure, holds expired Timers waiting for their Callback in FIFO order
+typedef struct ready_obj {
+	INT32U	timer_count;
+	INT32U	head_idx;
+	INT32U	tail_idx;
+} READY_OBJ;
+
+// Watchdog Report Function, called after a Callback ran longer than the threshold given to RTOSTmrWatchdogSet()
+typedef void (*RTOS_TMR_WATCHDOG_HOOK)(RTOS_TMR *ptmr, INT8 *name, INT32U elapsed_us, INT8U strikes);
+
+// Timer Information returned by RTOSTmrIterNext()
+typedef struct os_timer_info {
+	RTOS_TMR	*RTOSTmrPtr;	/* Timer the information was read from */
+	INT8	*RTOSTmrName;
+	INT32U	RTOSTmrRemain;	/* Ticks left for a Running Timer, 0 otherwise */
+	INT32U	RTOSTmrPeriod;
+	INT8U	RTOSTmrOpt;
+	INT8U	RTOSTmrState;
+	INT8U	RTOSTmrPrio;
+	INT8U	RTOSTmrStrikes;
+} RTOS_TMR_INFO;
+
+// Timer Iterator, walks the Slab without taking any Mutex
+typedef struct os_timer_iter {
+	INT32U	next_idx;	/* Next Slab index to look at */
+} RTOS_TMR_ITER;
+
+// Snapshot File Header
+typedef struct os_timer_snap_hdr {
+	INT32U	RTOSSnapMagic;	/* RTOS_TMR_SNAP_MAGIC */
+	INT32U	RTOSSnapVersion;	/* RTOS_TMR_SNAP_VERSION */
+	INT32U	RTOSSnapCount;	/* Number of Timer Records following the Header */
+	INT32U	RTOSSnapTick;	/* Tick Counter when the Snapshot finished, deadlines are re-armed relative to it */
+} RTOS_TMR_SNAP_HDR;
+
+// Snapshot File Timer Record
+typedef struct os_timer_snap_rec {
+	INT64U	RTOSTmrArg;	/* Callback Argument, saved and restored as a plain value */
+	INT32U	RTOSTmrCallbackId;	/* Stable id given to the Callback with RTOSTmrCallbackRegister() */
+	INT32U	RTOSTmrMatch;	/* Tick a Running Timer expires on, in the saving Tick Counter */
+	INT32U	RTOSTmrDelay;
+	INT32U	RTOSTmrPeriod;
+	INT8U	RTOSTmrOpt;
+	INT8U	RTOSTmrState;
+	INT8U	RTOSTmrPrio;
+	INT8U	RTOSTmrOverrun;
+} RTOS_TMR_SNAP_REC;
+
+// Expiry Statistics Structure
+typedef struct os_timer_stats {
+	INT32U	RTOSTmrBudgetHits;	/* Ticks that ran out of budget with expiries left over */
+	INT32U	RTOSTmrDeferred;	/* Expiries dispatched after their deadline tick */
+	INT64U	RTOSTmrDeferredTicks;	/* Total ticks waited by the deferred expiries */
+	INT32U	RTOSTmrDeferredMax;	/* Longest wait of a single deferred expiry in ticks */
+	INT32U	RTOSTmrBacklog;	/* Expiries still waiting at the end of the last tick */
+	INT64U	RTOSTmrSkipped;	/* Periods dropped by the SKIP and COALESCE overrun policies */
+	INT32U	RTOSTmrSlowCallbacks;	/* Callbacks that ran past the watchdog threshold */
+	INT32U	RTOSTmrQuarantined;	/* Expiries handed to the quarantine thread */
+	INT32U	RTOSTmrShmDropped;	/* Expiries lost because a Shared Memory client's ring was full */
+} RTOS_TMR_STATS;
+
+// Lock Statistics Structure, only collected when TimerAPI.c is built with RTOS_CFG_LOCK_STATS
+typedef struct os_lock_stats {
+	INT64U	acquired;	/* Times the Mutex was taken */
+	INT64U	contended;	/* Times it was already held and the caller had to wait */
+	INT64U	wait_ns;	/* Total time spent waiting for it */
+	INT64U	hold_ns;	/* Total time it was held */
+	INT64U	hold_start_ns;	/* When the current holder took it */
+} RTOS_LOCK_STATS;
+
+// Shared Memory Client Entry Structure, a ring of expired Timer Slab indexes the client has to call back
+typedef struct shm_client_obj {
+	INT32U	in_use;
+	INT32U	pid;	/* Process holding the slot, the slot is reclaimed once it no longer exists */
+	INT32U	head;	/* Next entry the client reads */
+	INT32U	tail;	/* Next entry the Timer Task writes */
+	INT32U	futex;	/* Bumped and woken every time the Timer Task adds entries */
+	INT32U	dropped;	/* Expiries lost because the ring was full */
+	INT32U	ring[RTOS_CFG_SHM_RING];
+} SHM_CLIENT_OBJ;
+
+// Timer Manager Control Block
+// Everything the Timer Task and the APIs share, kept in one place so it can live in a Shared Memory segment
+// with the Slab following it, or in plain process memory otherwise
+typedef struct os_timer_ctrl {
+	INT32U	magic;	/* RTOS_TMR_SHM_MAGIC once a Shared Memory segment is ready */
+
+	// Tick Counter
+	INT32U	RTOSTmrTickCtr;
+
+	// Timer Pool
+	INT32U	RTOSTmrPoolSize;
+	INT32U	FreeTmrCount;
+	INT32U	FreeTmrListIdx;
+
+	// Per-Tick Budget for running Callbacks of Priorities below RTOS_TMR_PRIO_HIGH
+	INT8U	RTOSTmrBudgetMode;
+	INT32U	RTOSTmrBudgetLimit;
+
+	// Expiry Statistics, protected by hash_table_mutex
+	RTOS_TMR_STATS	RTOSTmrStats;
+
+	// Hash Table
+	HASH_OBJ	hash_table[HASH_TABLE_SIZE];
+
+	// Ready Queues of expired Timers, one per Priority
+	READY_OBJ	ready_queue[RTOS_TMR_PRIO_LEVELS];
+
+	// Expired Timers with too many watchdog strikes, run by the quarantine thread instead of the Timer Task
+	READY_OBJ	quarantine_queue;
+
+	// Mutex for Protecting Hash Table, Ready Queues and Timer States
+	pthread_mutex_t	hash_table_mutex;
+
+	// Mutex for Protecting Timer Pool
+	pthread_mutex_t	timer_pool_mutex;
+
+	// Shared Memory clients, slots and ring tails protected by hash_table_mutex, each client moves its own head
+	SHM_CLIENT_OBJ	shm_client[RTOS_CFG_SHM_CLIENTS];
+} RTOS_TMR_CTRL;
+
 #endif
@@ -5,6 +5,7 @@
 typedef unsigned char INT8U;
 typedef unsigned short int INT16U;
 typedef unsigned int INT32U;
+typedef unsigned long long INT64U;
 
 typedef char INT8;
 typedef short int INT16;
@@ -4,32 +4,170 @@
 #include "TimerAPI.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 #include <semaphore.h>
+#include <sched.h>
 #include <signal.h>
 #include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <libgen.h>
+#include <linux/futex.h>
 
 /*****************************************************
  * Global Variables
  *****************************************************
  */
-// Timer Pool Global Variables
-INT8U FreeTmrCount = 0;
-RTOS_TMR *FreeTmrListPtr = NULL;
+// Thread variable for Timer Task
+pthread_t thread;
 
-// Tick Counter
-INT32U RTOSTmrTickCtr = 0;
+// Timer Manager Control Block, points into the Shared Memory segment when one is used
+RTOS_TMR_CTRL RTOSTmrLocalCtrl;
+RTOS_TMR_CTRL *RTOSTmrCtrl = &RTOSTmrLocalCtrl;
 
-// Hash Table
-HASH_OBJ hash_table[HASH_TABLE_SIZE];
+// Timer Pool Slab, as mapped in this process
+RTOS_TMR *RTOSTmrSlab = NULL;
+
+// Owner id of this process, RTOS_TMR_OWNER_SERVICE unless attached as a Shared Memory client
+INT8U RTOSTmrOwnerId = RTOS_TMR_OWNER_SERVICE;
+
+// Shared Memory segment mapping
+void *RTOSTmrShmBase = NULL;
+size_t RTOSTmrShmSize = 0;
+
+// Dropped count of this client's ring as of the last RTOSTmrShmDispatch()
+INT32U RTOSTmrShmDroppedSeen = 0;
+
+// Callback Table, Timers refer to their Callback by index, protected by timer_pool_mutex for updates
+RTOS_TMR_CALLBACK RTOSTmrCallbackTbl[RTOS_CFG_TMR_CALLBACKS];
+INT32U RTOSTmrCallbackStableId[RTOS_CFG_TMR_CALLBACKS];
+INT32U RTOSTmrCallbackCount = 1;
+
+// Open addressed hash from Callback Function to Callback Table index, 0 marks an empty slot
+// Slots are only ever filled, so lookups read it without a Mutex
+INT16U RTOSTmrCallbackHash[RTOS_CFG_TMR_CALLBACK_HASH];
+
+// Name Side Table indexed like the Slab, only allocated once a Timer is given a name
+INT8 **RTOSTmrNameTbl = NULL;
+
+// Optional Name Index, hashed buckets of Slab indexes chained through RTOSTmrNameNext
+INT32U *RTOSTmrNameBucket = NULL;
+INT32U *RTOSTmrNameNext = NULL;
+INT32U RTOSTmrNameBuckets = 0;
+
+// Mutex for Protecting the Name Index, kept apart so lookups never hold up the Timer Task
+pthread_mutex_t name_index_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Clock Source driving the Tick Counter
+INT8U RTOSTmrClockMode = RTOS_TMR_CLOCK_REAL;
 
 // Semaphore for Signaling the Timer Task
 sem_t timer_task_sem;
 
-// Mutex for Protecting Hash Table
-pthread_mutex_t hash_table_mutex;
+// Callback Watchdog, off while the threshold is 0, set up by RTOSTmrWatchdogSet()
+INT32U RTOSTmrWatchdogUsec = 0;
+INT8U RTOSTmrWatchdogStrikes = 0;
+RTOS_TMR_WATCHDOG_HOOK RTOSTmrWatchdogHook = NULL;
+
+// Default watchdog report, time of the last one printed and overruns left out since
+INT64U RTOSTmrWatchdogPrintNs = 0;
+INT32U RTOSTmrWatchdogSuppressed = 0;
+
+// Quarantine Task running the Callbacks of repeat offenders, started the first time quarantine is turned on
+pthread_t quarantine_thread;
+INT8U quarantine_started = RTOS_FALSE;
+sem_t quarantine_sem;
+
+// Mutex for Protecting the Watchdog settings and the Quarantine Task start
+pthread_mutex_t watchdog_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Lock Statistics for hash_table_mutex and timer_pool_mutex in this process
+RTOS_LOCK_STATS RTOSTmrLockStats[2];
+
+// Mutex wrappers, timed only when built with RTOS_CFG_LOCK_STATS
+#ifdef RTOS_CFG_LOCK_STATS
+#define RTOS_MUTEX_LOCK(m)	lock_stats_lock(m)
+#define RTOS_MUTEX_UNLOCK(m)	lock_stats_unlock(m)
+#else
+#define RTOS_MUTEX_LOCK(m)	pthread_mutex_lock(m)
+#define RTOS_MUTEX_UNLOCK(m)	pthread_mutex_unlock(m)
+#endif
+
+// Convert between Slab Index links and Timer Object pointers
+#define RTOS_TMR_PTR(idx)	((idx) == RTOS_TMR_NIL ? NULL : &RTOSTmrSlab[idx])
+#define RTOS_TMR_IDX(ptr)	((INT32U)((ptr) - RTOSTmrSlab))
+
+// RTOSTmrNameNext value of a Timer that is not in the Name Index
+#define RTOS_TMR_NAME_UNINDEXED	0xFFFFFFFE
+
+// Mark the start and end of a change to a Timer record for lock-free readers, the sequence is odd in between
+#define RTOS_TMR_WRITE_BEGIN(ptr)	do { __atomic_add_fetch(&(ptr)->RTOSTmrSeq, 1, __ATOMIC_RELAXED); __atomic_thread_fence(__ATOMIC_RELEASE); } while (0)
+#define RTOS_TMR_WRITE_END(ptr)	__atomic_add_fetch(&(ptr)->RTOSTmrSeq, 1, __ATOMIC_RELEASE)
+
+#ifdef RTOS_CFG_LOCK_STATS
+// Read the monotonic clock in ns
+static INT64U lock_stats_now(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (INT64U)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// Find the Lock Statistics of one of the Control Block Mutexes
+static RTOS_LOCK_STATS *lock_stats_find(pthread_mutex_t *mutex)
+{
+	if (mutex == &RTOSTmrCtrl->hash_table_mutex)
+		return &RTOSTmrLockStats[0];
+	if (mutex == &RTOSTmrCtrl->timer_pool_mutex)
+		return &RTOSTmrLockStats[1];
+	return NULL;
+}
+
+// Take a Mutex, timing the wait if somebody else holds it
+static int lock_stats_lock(pthread_mutex_t *mutex)
+{
+	RTOS_LOCK_STATS *stats = lock_stats_find(mutex);
+	INT64U start;
+	int ret;
+
+	if (stats == NULL)
+		return pthread_mutex_lock(mutex);
+
+	if (pthread_mutex_trylock(mutex) == 0) {
+		stats->hold_start_ns = lock_stats_now();
+	}
+	else {
+		start = lock_stats_now();
+		ret = pthread_mutex_lock(mutex);
+		if (ret != 0)
+			return ret;
+		stats->hold_start_ns = lock_stats_now();
+		__atomic_add_fetch(&stats->contended, 1, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&stats->wait_ns, stats->hold_start_ns - start, __ATOMIC_RELAXED);
+	}
+	__atomic_add_fetch(&stats->acquired, 1, __ATOMIC_RELAXED);
+
+	return 0;
+}
 
-// Mutex for Protecting Timer Pool
-pthread_mutex_t timer_pool_mutex;
+// Release a Mutex, adding up how long it was held
+static int lock_stats_unlock(pthread_mutex_t *mutex)
+{
+	RTOS_LOCK_STATS *stats = lock_stats_find(mutex);
+
+	if (stats != NULL)
+		__atomic_add_fetch(&stats->hold_ns, lock_stats_now() - stats->hold_start_ns, __ATOMIC_RELAXED);
+
+	return pthread_mutex_unlock(mutex);
+}
+#endif
 
 /*****************************************************
  * Timer API Functions
@@ -40,6 +178,7 @@ pthread_mutex_t timer_pool_mutex;
 RTOS_TMR* RTOSTmrCreate(INT32U delay, INT32U period, INT8U option, RTOS_TMR_CALLBACK callback, void *callback_arg, INT8	*name, INT8U *err)
 {
 	RTOS_TMR *timer_obj = NULL;
+	INT16U callback_id;
 
 	// Check the input Arguments for ERROR
 
@@ -66,6 +205,13 @@ RTOS_TMR* RTOSTmrCreate(INT32U delay, INT32U period, INT8U option, RTOS_TMR_CALL
         return NULL;
 	}
 
+	// Find the Callback in the Callback Table
+	callback_id = register_callback(callback);
+	if (callback_id == 0 && callback != NULL) {
+		*err = RTOS_ERR_TMR_CALLBACK_FULL;
+		return NULL;
+	}
+
 	// Allocate a New Timer Obj
 	timer_obj = alloc_timer_obj();
 
@@ -77,6 +223,17 @@ RTOS_TMR* RTOSTmrCreate(INT32U delay, INT32U period, INT8U option, RTOS_TMR_CALL
 
 	*err = RTOS_ERR_NONE;
 
+	// Names go in the Side Table, created the first time a name is used
+	// It is set up before the record is opened for writing so RTOSTmrIterNext() never waits on the allocation
+	if (name != NULL && RTOSTmrNameTbl == NULL) {
+		RTOS_MUTEX_LOCK(&RTOSTmrCtrl->timer_pool_mutex);
+		if (RTOSTmrNameTbl == NULL)
+			RTOSTmrNameTbl = calloc(RTOSTmrCtrl->RTOSTmrPoolSize, sizeof(INT8 *));
+		RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->timer_pool_mutex);
+	}
+
+	RTOS_TMR_WRITE_BEGIN(timer_obj);
+
 	// Fill up the Timer Object with inputs
 	timer_obj->RTOSTmrType = RTOS_TMR_TYPE;
 	// Period and delay are being input in seconds
@@ -85,16 +242,34 @@ RTOS_TMR* RTOSTmrCreate(INT32U delay, INT32U period, INT8U option, RTOS_TMR_CALL
 	timer_obj->RTOSTmrDelay = delay*10;
 	timer_obj->RTOSTmrPeriod = period*10;
 	timer_obj->RTOSTmrOpt = option;
-	timer_obj->RTOSTmrCallback = callback;
+	timer_obj->RTOSTmrCallbackId = callback_id;
 	timer_obj->RTOSTmrCallbackArg = callback_arg;
-	timer_obj->RTOSTmrName = name;
-
-	// Set pointers and state
-	timer_obj->RTOSTmrNext = NULL;
-	timer_obj->RTOSTmrPrev = NULL;
+	timer_obj->RTOSTmrOwner = RTOSTmrOwnerId;
+	timer_obj->RTOSTmrPrio = RTOS_TMR_PRIO_NORMAL;
+	timer_obj->RTOSTmrOverrun = RTOS_TMR_OVERRUN_SKIP;
+	timer_obj->RTOSTmrMissed = 0;
+	timer_obj->RTOSTmrStrikes = 0;
+
+	// The Side Table entry belongs to this record alone, no Mutex needed
+	if (RTOSTmrNameTbl != NULL)
+		RTOSTmrNameTbl[RTOS_TMR_IDX(timer_obj)] = name;
+
+	// Set links and state
+	timer_obj->RTOSTmrNext = RTOS_TMR_NIL;
+	timer_obj->RTOSTmrPrev = RTOS_TMR_NIL;
+	timer_obj->RTOSTmrQueue = RTOS_TMR_QUEUE_NONE;
 	timer_obj->RTOSTmrState = RTOS_TMR_STATE_STOPPED;
 	timer_obj->RTOSTmrMatch = 0;
 
+	RTOS_TMR_WRITE_END(timer_obj);
+
+	// Make the Timer findable by name
+	if (name != NULL) {
+		RTOS_MUTEX_LOCK(&name_index_mutex);
+		insert_name_entry(timer_obj);
+		RTOS_MUTEX_UNLOCK(&name_index_mutex);
+	}
+
 	return timer_obj;
 }
 
@@ -120,19 +295,34 @@ INT8U RTOSTmrDel(RTOS_TMR *ptmr, INT8U *perr)
     }
     *perr = RTOS_ERR_NONE;
 
-	// Free Timer Object according to its State
+	// Lock the Resources
+	RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
 
-	// Need to stop the timer if it is running
-	if (ptmr->RTOSTmrState == RTOS_TMR_STATE_RUNNING){
-		// Don't want a callback, just want to delete it
-    	RTOSTmrStop(ptmr, RTOS_TMR_OPT_NONE, NULL, perr);
-    	// Make sure the timer was stopped
-    	if (perr != RTOS_ERR_NONE)
-    		return RTOS_FALSE;
-    }
-    // Now we can delete it
+	RTOS_TMR_WRITE_BEGIN(ptmr);
+
+	// Take it off the Hash Table or Ready Queue whatever its State
+	// A Periodic Timer whose Callback is running is COMPLETED and gets armed again by the Timer Task afterwards,
+	// marking it Unused under the Mutex makes run_ready_timer() leave it alone
 	remove_hash_entry(ptmr);
-	free_timer_obj(ptmr);
+	ptmr->RTOSTmrState = RTOS_TMR_STATE_UNUSED;
+
+	RTOS_TMR_WRITE_END(ptmr);
+
+	// Unlock the Resources
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+    // Now we can delete it
+	// A named Timer leaves the Name Index in the same hold of name_index_mutex, so RTOSTmrNameIndexEnable()
+	// sees it either still in use or already freed
+	if (RTOSTmrNameTbl != NULL && RTOSTmrNameTbl[RTOS_TMR_IDX(ptmr)] != NULL) {
+		RTOS_MUTEX_LOCK(&name_index_mutex);
+		remove_name_entry(ptmr);
+		free_timer_obj(ptmr);
+		RTOS_MUTEX_UNLOCK(&name_index_mutex);
+	}
+	else {
+		free_timer_obj(ptmr);
+	}
 
 	return RTOS_TRUE;
 }
@@ -160,7 +350,9 @@ INT8* RTOSTmrNameGet(RTOS_TMR *ptmr, INT8U *perr)
 	*perr = RTOS_ERR_NONE;
 
 	// Return the Pointer to the String
-	return ptmr->RTOSTmrName;
+	if (RTOSTmrNameTbl == NULL)
+		return NULL;
+	return RTOSTmrNameTbl[RTOS_TMR_IDX(ptmr)];
 }
 
 // To Get the Number of ticks remaining in time out
@@ -185,8 +377,12 @@ INT32U RTOSTmrRemainGet(RTOS_TMR *ptmr, INT8U *perr)
     }
 	*perr = RTOS_ERR_NONE;
 
+	// Expired Timers waiting in a Ready Queue have nothing left
+	if (RTOS_TMR_TICK_REACHED(ptmr->RTOSTmrMatch, RTOSTmrCtrl->RTOSTmrTickCtr))
+		return 0;
+
 	// Return the remaining ticks
-	return ptmr->RTOSTmrMatch - RTOSTmrTickCtr;
+	return ptmr->RTOSTmrMatch - RTOSTmrCtrl->RTOSTmrTickCtr;
 }
 
 // To Get the state of the Timer
@@ -240,18 +436,37 @@ INT8U RTOSTmrStart(RTOS_TMR *ptmr, INT8U *perr)
 	// Based on the Timer State, update the RTOSTmrMatch using RTOSTmrTickCtr, RTOSTmrDelay and RTOSTmrPeriod
 	// You may use the Hash Table to Insert the Running Timer Obj
 
+	// Lock the Resources
+	RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	RTOS_TMR_WRITE_BEGIN(ptmr);
+
+	// Restarting a Running Timer, take it off its current list first
+	remove_hash_entry(ptmr);
+
 	ptmr->RTOSTmrState = RTOS_TMR_STATE_RUNNING;
 
 	// If the timer is configured for PERIODIC mode, delay is the first timeout to wait for
 	// before the timer starts entering periodic mode
 	// If delay is zero, will just start in periodic
-	if (ptmr->RTOSTmrOpt == RTOS_TMR_PERIODIC && ptmr->RTOSTmrDelay == 0)
-        ptmr->RTOSTmrDelay = ptmr->RTOSTmrPeriod;
-	ptmr->RTOSTmrMatch = RTOSTmrTickCtr + ptmr->RTOSTmrDelay;
-    ptmr->RTOSTmrDelay = 0;
+	// One Shot Timers keep their delay so they can be started again
+	if (ptmr->RTOSTmrOpt == RTOS_TMR_PERIODIC) {
+		if (ptmr->RTOSTmrDelay == 0)
+			ptmr->RTOSTmrDelay = ptmr->RTOSTmrPeriod;
+		ptmr->RTOSTmrMatch = RTOSTmrCtrl->RTOSTmrTickCtr + ptmr->RTOSTmrDelay;
+		ptmr->RTOSTmrDelay = 0;
+	}
+	else {
+		ptmr->RTOSTmrMatch = RTOSTmrCtrl->RTOSTmrTickCtr + ptmr->RTOSTmrDelay;
+	}
 
     insert_hash_entry(ptmr);
 
+	RTOS_TMR_WRITE_END(ptmr);
+
+	// Unlock the Resources
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+
     return RTOS_TRUE;
 }
 
@@ -283,28 +498,43 @@ INT8U RTOSTmrStop(RTOS_TMR *ptmr, INT8U opt, void *callback_arg, INT8U *perr)
         *perr = RTOS_ERR_TMR_INVALID_STATE;
         return RTOS_FALSE;
     }
-    if(ptmr->RTOSTmrCallback == NULL && opt == RTOS_TMR_OPT_CALLBACK){
+    if(ptmr->RTOSTmrCallbackId == 0 && opt != RTOS_TMR_OPT_NONE){
         *perr = RTOS_ERR_TMR_NO_CALLBACK;
         return RTOS_FALSE;
     }
     if(callback_arg == NULL && opt == RTOS_TMR_OPT_CALLBACK_ARG){
         *perr = RTOS_ERR_TMR_NO_CALLBACK;
         return RTOS_FALSE;
+    }
+	// The Callback id of a Shared Memory Timer only means something in the process owning it
+    if(ptmr->RTOSTmrOwner != RTOSTmrOwnerId && opt != RTOS_TMR_OPT_NONE){
+        *perr = RTOS_ERR_TMR_NOT_OWNER;
+        return RTOS_FALSE;
     }
 	*perr = RTOS_ERR_NONE;
 
-	// Remove the Timer from the Hash Table List
+	// Lock the Resources
+	RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	RTOS_TMR_WRITE_BEGIN(ptmr);
+
+	// Remove the Timer from the Hash Table List or Ready Queue
 	remove_hash_entry(ptmr);
 
 	// Change the State to Stopped
 	ptmr->RTOSTmrState = RTOS_TMR_STATE_STOPPED;
 
+	RTOS_TMR_WRITE_END(ptmr);
+
+	// Unlock the Resources
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+
 	// Call the Callback function if required
 	if(opt == RTOS_TMR_OPT_CALLBACK){
-        ptmr->RTOSTmrCallback(ptmr->RTOSTmrCallbackArg);
+        RTOSTmrCallbackTbl[ptmr->RTOSTmrCallbackId](ptmr->RTOSTmrCallbackArg);
     }
     if(opt == RTOS_TMR_OPT_CALLBACK_ARG){
-        ptmr->RTOSTmrCallback(callback_arg);
+        RTOSTmrCallbackTbl[ptmr->RTOSTmrCallbackId](callback_arg);
     }
     return RTOS_TRUE;
 }
@@ -317,249 +547,1767 @@ void RTOSTmrSignal(int signum)
 	sem_post(&timer_task_sem);
 }
 
-/*****************************************************
- * Internal Functions
- *****************************************************
- */
-
-// Create Pool of Timers
-INT8U Create_Timer_Pool(INT32U timer_count)
+// Function to Initialize the Timer Manager on a Virtual Clock
+// No Timer Task is created, time only moves when the Application calls RTOSTmrAdvance() or RTOSTmrRunUntil()
+// and Callbacks run on the calling thread, so the same sequence of calls always gives the same expiries
+INT8U RTOSTmrInitVirtual(INT32U timer_count, INT8U *perr)
 {
-	// Create the Timer pool using Dynamic Memory Allocation
-	// You can imagine of LinkedList Creation for Timer Obj
-	FreeTmrCount = timer_count;
+	if (init_timer_engine(timer_count, PTHREAD_PROCESS_PRIVATE) != RTOS_SUCCESS){
+		*perr = RTOS_MALLOC_ERR;
+		return RTOS_FALSE;
+	}
+	*perr = RTOS_ERR_NONE;
 
-	for (int i=0; i<timer_count; i++){
-		RTOS_TMR *tmr = malloc(sizeof(RTOS_TMR));
-		tmr->RTOSTmrType = RTOS_TMR_TYPE;
-		tmr->RTOSTmrCallback = NULL;
-		tmr->RTOSTmrCallbackArg = NULL;
-		tmr->RTOSTmrMatch = 0;
-		tmr->RTOSTmrDelay = 0;
-		tmr->RTOSTmrPeriod = 0;
-		tmr->RTOSTmrName = NULL;
-		tmr->RTOSTmrOpt = 0;
-		tmr->RTOSTmrState = RTOS_TMR_STATE_UNUSED;
-		tmr->RTOSTmrNext = NULL;
-		if (i == 0) {
-			tmr->RTOSTmrPrev = NULL;
-			tmr->RTOSTmrNext = NULL;
-			FreeTmrListPtr = tmr;
-		} 
-		else {
-			tmr->RTOSTmrNext = FreeTmrListPtr;
-			tmr->RTOSTmrPrev = NULL;
-			FreeTmrListPtr->RTOSTmrPrev = tmr;
-			FreeTmrListPtr = tmr;
+	RTOSTmrClockMode = RTOS_TMR_CLOCK_VIRTUAL;
+
+	return RTOS_TRUE;
+}
+
+// Ticks until the earliest Timer in the Hash Table reaches its Match, 0 if one already has
+// Caller must hold hash_table_mutex
+static INT32U next_expiry_distance(void)
+{
+	INT32U distance = UINT_MAX;
+	RTOS_TMR *tmr;
+	int i;
+
+	for (i=0; i<HASH_TABLE_SIZE; i++) {
+		for (tmr = RTOS_TMR_PTR(RTOSTmrCtrl->hash_table[i].list_idx); tmr != NULL; tmr = RTOS_TMR_PTR(tmr->RTOSTmrNext)) {
+			if (RTOS_TMR_TICK_REACHED(tmr->RTOSTmrMatch, RTOSTmrCtrl->RTOSTmrTickCtr))
+				return 0;
+			if (tmr->RTOSTmrMatch - RTOSTmrCtrl->RTOSTmrTickCtr < distance)
+				distance = tmr->RTOSTmrMatch - RTOSTmrCtrl->RTOSTmrTickCtr;
 		}
 	}
 
-	return RTOS_SUCCESS;
+	return distance;
 }
 
-// Initialize the Hash Table
-void init_hash_table(void)
-{	
-	// Make sure everything is empty
-	for (int i=0; i<HASH_TABLE_SIZE; i++){
-		hash_table[i].timer_count = 0;
-		hash_table[i].list_ptr = NULL;
+// Function to move the Virtual Clock forward by a number of Ticks
+// Stretches where no Timer can expire are jumped over rather than run a Tick at a time
+INT8U RTOSTmrAdvance(INT32U ticks, INT8U *perr)
+{
+	INT32U pending;
+	INT32U ready;
+	INT32U skip;
+	INT32U idle = 0;
+	int i;
+
+	// ERROR Checking
+	if(RTOSTmrClockMode != RTOS_TMR_CLOCK_VIRTUAL){
+		*perr = RTOS_ERR_TMR_NOT_VIRTUAL;
+		return RTOS_FALSE;
+	}
+	*perr = RTOS_ERR_NONE;
+
+	while (ticks > 0) {
+		// Lock the Resources
+		RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+		pending = 0;
+		for (i=0; i<HASH_TABLE_SIZE; i++)
+			pending += RTOSTmrCtrl->hash_table[i].timer_count;
+		ready = RTOSTmrCtrl->quarantine_queue.timer_count;
+		for (i=0; i<RTOS_TMR_PRIO_LEVELS; i++)
+			ready += RTOSTmrCtrl->ready_queue[i].timer_count;
+
+		// Nothing can expire, jump straight to the end
+		if (pending + ready == 0) {
+			RTOSTmrCtrl->RTOSTmrTickCtr += ticks;
+			RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+			break;
+		}
+
+		// A whole turn of the Hash Table went by with nothing expiring, jump to just before the earliest deadline
+		// Waiting for the idle turn keeps the scan of every Timer off busy stretches where it would not pay off
+		if (ready == 0 && idle >= HASH_TABLE_SIZE) {
+			skip = next_expiry_distance();
+			skip = (skip > 0) ? skip - 1 : 0;
+			if (skip > ticks)
+				skip = ticks;
+			RTOSTmrCtrl->RTOSTmrTickCtr += skip;
+			ticks -= skip;
+			idle = 0;
+		}
+
+		// Unlock the Resources
+		RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+		if (ticks == 0)
+			break;
+
+		if (process_tick() == 0)
+			idle++;
+		else
+			idle = 0;
+		ticks--;
 	}
+
+	return RTOS_TRUE;
 }
 
-// Insert a Timer Object in the Hash Table
-void insert_hash_entry(RTOS_TMR *timer_obj)
+// Function to move the Virtual Clock forward until the Tick Counter reaches the deadline
+INT8U RTOSTmrRunUntil(INT32U deadline, INT8U *perr)
 {
-	// Calculate the index using Hash Function
-	int idx = (RTOSTmrTickCtr + timer_obj->RTOSTmrDelay) % HASH_TABLE_SIZE;
-	
-	// Lock the Resources
-	pthread_mutex_lock(&hash_table_mutex);
+	// Deadline already reached, nothing to run
+	if (RTOS_TMR_TICK_REACHED(deadline, RTOSTmrCtrl->RTOSTmrTickCtr)) {
+		if(RTOSTmrClockMode != RTOS_TMR_CLOCK_VIRTUAL){
+			*perr = RTOS_ERR_TMR_NOT_VIRTUAL;
+			return RTOS_FALSE;
+		}
+		*perr = RTOS_ERR_NONE;
+		return RTOS_TRUE;
+	}
 
-	// Add the Entry
-	if (!hash_table[idx].list_ptr)
-		hash_table[idx].list_ptr = timer_obj;
-	else{
-		// Just place timer at beginning of list
-		// TmrTask will perform a linear search
-		RTOS_TMR *temp = hash_table[idx].list_ptr;
-		timer_obj->RTOSTmrNext = hash_table[idx].list_ptr;
-		hash_table[idx].list_ptr->RTOSTmrPrev = timer_obj;
-		timer_obj->RTOSTmrPrev = NULL;
-		hash_table[idx].list_ptr = timer_obj;		
-	}
-	hash_table[idx].timer_count++;
+	return RTOSTmrAdvance(deadline - RTOSTmrCtrl->RTOSTmrTickCtr, perr);
+}
 
-	// Unlock the Resources
-	pthread_mutex_unlock(&hash_table_mutex);
+// To Get the current value of the Tick Counter
+INT32U RTOSTmrTickGet(void)
+{
+	return RTOSTmrCtrl->RTOSTmrTickCtr;
 }
 
-// Remove the Timer Object entry from the Hash Table
-void remove_hash_entry(RTOS_TMR *timer_obj)
+// Function to start the Timer Manager as a Shared Memory Timer Service
+// The Control Block and Timer Pool are placed in the POSIX Shared Memory object name, this process runs the
+// only Timer Task and client processes attach with RTOSTmrShmAttach() to create and start Timers in the same pool
+// A segment left under the same name is unlinked first, clients still mapping it keep the old copy untouched
+INT8U RTOSTmrShmServiceInit(const char *name, INT32U timer_count, INT8U *perr)
 {
-	// Calculate the index using Hash Function
-	int idx = (RTOSTmrTickCtr + timer_obj->RTOSTmrDelay) % HASH_TABLE_SIZE;
+	size_t size = sizeof(RTOS_TMR_CTRL) + (size_t)timer_count * sizeof(RTOS_TMR);
+	INT8U retVal;
+	void *base;
+	int fd;
+
+	shm_unlink(name);
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd < 0) {
+		*perr = RTOS_ERR_TMR_SHM;
+		return RTOS_FALSE;
+	}
+	if (ftruncate(fd, size) != 0) {
+		close(fd);
+		shm_unlink(name);
+		*perr = RTOS_ERR_TMR_SHM;
+		return RTOS_FALSE;
+	}
+	base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED) {
+		shm_unlink(name);
+		*perr = RTOS_ERR_TMR_SHM;
+		return RTOS_FALSE;
+	}
 
-	// Lock the Resources
-	pthread_mutex_lock(&hash_table_mutex);
+	RTOSTmrShmBase = base;
+	RTOSTmrShmSize = size;
+	RTOSTmrCtrl = base;
+	RTOSTmrSlab = (RTOS_TMR *)(RTOSTmrCtrl + 1);
+	RTOSTmrOwnerId = RTOS_TMR_OWNER_SERVICE;
 
-	// Remove the Timer Obj
-	if (hash_table[idx].timer_count == 1){
-		hash_table[idx].list_ptr == NULL;
-		hash_table[idx].timer_count = 0;
+	retVal = init_timer_engine(timer_count, PTHREAD_PROCESS_SHARED);
+
+	// Initialize Semaphore and Thread for Timer Task, ticks come from OSTickInitialize() as usual
+	if (retVal == RTOS_SUCCESS && sem_init(&timer_task_sem, 0, 0) != 0)
+		retVal = RTOS_ERR_TMR_SHM;
+	else if (retVal == RTOS_SUCCESS && pthread_create(&thread, NULL, RTOSTmrTask, NULL) != 0) {
+		sem_destroy(&timer_task_sem);
+		retVal = RTOS_ERR_TMR_SHM;
 	}
-	else {
-		// timer_obj is first entry
-		if (timer_obj == hash_table[idx].list_ptr){
-			timer_obj->RTOSTmrNext->RTOSTmrPrev = NULL;
-			hash_table[idx].list_ptr = timer_obj->RTOSTmrNext;
-		}
-		// timer_obj is last entry
-		else if (timer_obj->RTOSTmrNext == NULL){
-			timer_obj->RTOSTmrPrev->RTOSTmrNext = NULL;
-		}
-		else {
-			timer_obj->RTOSTmrNext->RTOSTmrPrev = timer_obj->RTOSTmrPrev;
-			timer_obj->RTOSTmrPrev->RTOSTmrNext = timer_obj->RTOSTmrNext;
-		}
-		hash_table[idx].timer_count--;
+
+	// Check the return Value, nobody can have attached yet so the segment just goes away
+	if (retVal != RTOS_SUCCESS) {
+		munmap(base, size);
+		shm_unlink(name);
+		RTOSTmrShmBase = NULL;
+		RTOSTmrShmSize = 0;
+		RTOSTmrCtrl = &RTOSTmrLocalCtrl;
+		RTOSTmrSlab = NULL;
+		*perr = RTOS_ERR_TMR_SHM;
+		return RTOS_FALSE;
 	}
 
-	// Unlock the Resources
-	pthread_mutex_unlock(&hash_table_mutex);
+	// Clients may attach from here on
+	__atomic_store_n(&RTOSTmrCtrl->magic, RTOS_TMR_SHM_MAGIC, __ATOMIC_RELEASE);
+
+	*perr = RTOS_ERR_NONE;
+	return RTOS_TRUE;
 }
 
-// Timer Task to Manage the Running Timers
-void *RTOSTmrTask(void *temp)
+// Function to attach this process as a client of a Shared Memory Timer Service
+// Timers created afterwards come from the shared pool, their Callbacks run in RTOSTmrShmDispatch()
+INT8U RTOSTmrShmAttach(const char *name, INT8U *perr)
 {
-	RTOS_TMR *tmr;
-	INT8U perr;
-	INT32U ret;
-	while(1) {
-		// Wait for the signal from RTOSTmrSignal()
-		sem_wait(&timer_task_sem);
-		// Once got the signal, Increment the Timer Tick Counter
-		RTOSTmrTickCtr++;
-
-		// Check the whole List associated with the index of the Hash Table
-		int idx = RTOSTmrTickCtr % HASH_TABLE_SIZE;
-
-		// Compare each obj of linked list for Timer Completion
-		// If the Timer is completed, Call its Callback Function, Remove the entry from Hash table
-		// If the Timer is Periodic then again insert it in the hash table
-		// Change the State
-		tmr = hash_table[idx].list_ptr;
-		while(tmr != NULL){
-			ret = RTOSTmrRemainGet(tmr, &perr);
-			if (perr != RTOS_ERR_NONE)
-				continue;
-			if (ret == 0){
-				RTOSTmrStop(tmr, RTOS_TMR_OPT_CALLBACK, NULL, &perr);
-				if (perr != RTOS_ERR_NONE)
-					continue;
-				tmr->RTOSTmrState = RTOS_TMR_STATE_COMPLETED;
-	            if(tmr->RTOSTmrOpt == RTOS_TMR_PERIODIC){
-	                RTOSTmrStart(tmr, &perr);
-	                if (perr != RTOS_ERR_NONE)
-						continue;
-	            }
-			}
-			tmr = tmr->RTOSTmrNext;
+	RTOS_TMR_CTRL *ctrl;
+	struct stat st;
+	void *base;
+	INT8U dead;
+	int fd;
+	int i;
+
+	fd = shm_open(name, O_RDWR, 0);
+	if (fd < 0) {
+		*perr = RTOS_ERR_TMR_SHM;
+		return RTOS_FALSE;
+	}
+	if (fstat(fd, &st) != 0 || st.st_size < sizeof(RTOS_TMR_CTRL)) {
+		close(fd);
+		*perr = RTOS_ERR_TMR_SHM;
+		return RTOS_FALSE;
+	}
+	base = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED) {
+		*perr = RTOS_ERR_TMR_SHM;
+		return RTOS_FALSE;
+	}
+	ctrl = base;
+	if (__atomic_load_n(&ctrl->magic, __ATOMIC_ACQUIRE) != RTOS_TMR_SHM_MAGIC ||
+	    st.st_size < sizeof(RTOS_TMR_CTRL) + (size_t)ctrl->RTOSTmrPoolSize * sizeof(RTOS_TMR)) {
+		munmap(base, st.st_size);
+		*perr = RTOS_ERR_TMR_SHM;
+		return RTOS_FALSE;
+	}
+
+	RTOSTmrShmBase = base;
+	RTOSTmrShmSize = st.st_size;
+	RTOSTmrCtrl = ctrl;
+	RTOSTmrSlab = (RTOS_TMR *)(ctrl + 1);
+
+	// Give back the slots of clients that exited without detaching, along with their Timers
+	// The slot is marked with this process while its Timers are deleted so nobody else claims it meanwhile
+	for (i=0; i<RTOS_CFG_SHM_CLIENTS; i++) {
+		RTOS_MUTEX_LOCK(&ctrl->hash_table_mutex);
+		dead = ctrl->shm_client[i].in_use && kill(ctrl->shm_client[i].pid, 0) != 0 && errno == ESRCH;
+		if (dead)
+			ctrl->shm_client[i].pid = getpid();
+		RTOS_MUTEX_UNLOCK(&ctrl->hash_table_mutex);
+
+		if (dead)
+			reclaim_shm_client(i);
+	}
+
+	// Claim a client slot
+	RTOS_MUTEX_LOCK(&ctrl->hash_table_mutex);
+	for (i=0; i<RTOS_CFG_SHM_CLIENTS; i++) {
+		if (!ctrl->shm_client[i].in_use) {
+			ctrl->shm_client[i].in_use = RTOS_TRUE;
+			ctrl->shm_client[i].pid = getpid();
+			ctrl->shm_client[i].head = ctrl->shm_client[i].tail;
+			ctrl->shm_client[i].dropped = 0;
+			break;
 		}
 	}
-	return temp;
+	RTOS_MUTEX_UNLOCK(&ctrl->hash_table_mutex);
+
+	if (i == RTOS_CFG_SHM_CLIENTS) {
+		munmap(base, st.st_size);
+		RTOSTmrShmBase = NULL;
+		RTOSTmrShmSize = 0;
+		RTOSTmrCtrl = &RTOSTmrLocalCtrl;
+		RTOSTmrSlab = NULL;
+		*perr = RTOS_ERR_TMR_SHM_FULL;
+		return RTOS_FALSE;
+	}
+
+	RTOSTmrOwnerId = i + 1;
+	RTOSTmrShmDroppedSeen = 0;
+
+	*perr = RTOS_ERR_NONE;
+	return RTOS_TRUE;
 }
 
-// Timer Initialization Function
-void RTOSTmrInit(void)
+// Function for a Shared Memory client to run the Callbacks of its expired Timers
+// Waits up to timeout_ms when nothing is queued, returns the number of Callbacks run
+// *perr is RTOS_ERR_TMR_SHM_DROPPED when the ring overflowed since the last call and expiries were lost
+INT32U RTOSTmrShmDispatch(INT32U timeout_ms, INT8U *perr)
 {
-	INT32U timer_count = 0;
-	INT8U	retVal;
-	pthread_attr_t attr;
+	SHM_CLIENT_OBJ *client;
+	RTOS_TMR *tmr;
+	RTOS_TMR_CALLBACK callback;
+	struct timespec timeout;
+	INT32U seq, head, tail;
+	INT32U dropped;
+	INT32U count = 0;
 
-	fprintf(stdout,"\n\nPlease Enter the number of Timers required in the Pool for the OS ");
-	scanf("%d", &timer_count);
+	// ERROR Checking
+	if (RTOSTmrOwnerId == RTOS_TMR_OWNER_SERVICE) {
+		*perr = RTOS_ERR_TMR_NOT_CLIENT;
+		return 0;
+	}
+	*perr = RTOS_ERR_NONE;
 
-	// Create Timer Pool
-	retVal = Create_Timer_Pool(timer_count);
+	client = &RTOSTmrCtrl->shm_client[RTOSTmrOwnerId - 1];
+	head = client->head;
 
-	// Check the return Value
-	if (retVal != RTOS_SUCCESS){
-		fprintf(stdout, "Error creating the timer pool\n");
-		return;
+	// Sleep on the futex until the Timer Task posts something
+	seq = __atomic_load_n(&client->futex, __ATOMIC_ACQUIRE);
+	if (__atomic_load_n(&client->tail, __ATOMIC_ACQUIRE) == head && timeout_ms > 0) {
+		timeout.tv_sec = timeout_ms / 1000;
+		timeout.tv_nsec = (timeout_ms % 1000) * 1000000;
+		syscall(SYS_futex, &client->futex, FUTEX_WAIT, seq, &timeout, NULL, 0);
 	}
 
-	// Init Hash Table
-	init_hash_table();
+	tail = __atomic_load_n(&client->tail, __ATOMIC_ACQUIRE);
+	while (head != tail) {
+		tmr = &RTOSTmrSlab[client->ring[head % RTOS_CFG_SHM_RING]];
+		head++;
+		__atomic_store_n(&client->head, head, __ATOMIC_RELEASE);
 
-	fprintf(stdout, "\n\nHash Table Initialized Successfully\n");
+		// The Timer may have been deleted since it expired
+		if (tmr->RTOSTmrOwner != RTOSTmrOwnerId || tmr->RTOSTmrState == RTOS_TMR_STATE_UNUSED)
+			continue;
 
-	// Initialize Semaphore for Timer Task
-	sem_init(&timer_task_sem, 0, 0);
+		callback = RTOSTmrCallbackTbl[tmr->RTOSTmrCallbackId];
+		if (callback != NULL)
+			callback(tmr->RTOSTmrCallbackArg);
+		count++;
+	}
 
-	// Initialize Mutex if any
-	pthread_mutex_init(&hash_table_mutex, NULL);
-	pthread_mutex_init(&timer_pool_mutex, NULL);
+	// Let the client know the Timer Task had to drop expiries for it
+	dropped = __atomic_load_n(&client->dropped, __ATOMIC_RELAXED);
+	if (dropped != RTOSTmrShmDroppedSeen) {
+		RTOSTmrShmDroppedSeen = dropped;
+		*perr = RTOS_ERR_TMR_SHM_DROPPED;
+	}
 
-	// Create any Thread if required for Timer Task
-	pthread_create(&thread, NULL, RTOSTmrTask, NULL);
+	return count;
+}
 
-	fprintf(stdout,"\nRTOS Initialization Done...\n");
+// Function to detach a Shared Memory client, deleting the Timers it still owns
+INT8U RTOSTmrShmDetach(INT8U *perr)
+{
+	INT32U i;
+	INT8U err;
+
+	// ERROR Checking
+	if (RTOSTmrOwnerId == RTOS_TMR_OWNER_SERVICE) {
+		*perr = RTOS_ERR_TMR_NOT_CLIENT;
+		return RTOS_FALSE;
+	}
+	*perr = RTOS_ERR_NONE;
+
+	for (i=0; i<RTOSTmrCtrl->RTOSTmrPoolSize; i++) {
+		if (RTOSTmrSlab[i].RTOSTmrOwner == RTOSTmrOwnerId && RTOSTmrSlab[i].RTOSTmrState != RTOS_TMR_STATE_UNUSED)
+			RTOSTmrDel(&RTOSTmrSlab[i], &err);
+	}
+
+	// Give the client slot back
+	RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+	RTOSTmrCtrl->shm_client[RTOSTmrOwnerId - 1].in_use = RTOS_FALSE;
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	munmap(RTOSTmrShmBase, RTOSTmrShmSize);
+	RTOSTmrShmBase = NULL;
+	RTOSTmrShmSize = 0;
+	RTOSTmrCtrl = &RTOSTmrLocalCtrl;
+	RTOSTmrSlab = NULL;
+	RTOSTmrOwnerId = RTOS_TMR_OWNER_SERVICE;
+
+	return RTOS_TRUE;
 }
 
-// Allocate a timer object from free timer pool
-RTOS_TMR* alloc_timer_obj(void)
+// Delete the Timers of a Shared Memory client slot and free the slot
+// Used for clients that went away without RTOSTmrShmDetach(), RTOSTmrCtrl must point at the segment
+void reclaim_shm_client(INT32U client)
 {
-	// Lock the Resources
-	pthread_mutex_lock(&timer_pool_mutex);
+	INT32U i;
+	INT8U err;
 
-	// Check for Availability of Timers
-	if (FreeTmrCount == 0){
-		fprintf(stdout, "Failed to allocated timer object, no free timers\n");
-		return NULL;
+	for (i=0; i<RTOSTmrCtrl->RTOSTmrPoolSize; i++) {
+		if (RTOSTmrSlab[i].RTOSTmrOwner == client + 1 && RTOSTmrSlab[i].RTOSTmrState != RTOS_TMR_STATE_UNUSED)
+			RTOSTmrDel(&RTOSTmrSlab[i], &err);
 	}
 
-	// Assign the Timer Object
-	RTOS_TMR *timer_obj = FreeTmrListPtr;
+	// Give the client slot back
+	RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+	RTOSTmrCtrl->shm_client[client].in_use = RTOS_FALSE;
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+}
 
-	if (FreeTmrCount == 1){
-        FreeTmrListPtr = NULL;
-    }
-    else {
-        FreeTmrListPtr = FreeTmrListPtr->RTOSTmrNext;
-        FreeTmrListPtr->RTOSTmrPrev = NULL;
-    }
+// Function to get the Lock Statistics of hash_table_mutex and timer_pool_mutex
+// They stay zero unless TimerAPI.c is built with RTOS_CFG_LOCK_STATS
+void RTOSTmrLockStatsGet(RTOS_LOCK_STATS *hash_stats, RTOS_LOCK_STATS *pool_stats)
+{
+	*hash_stats = RTOSTmrLockStats[0];
+	*pool_stats = RTOSTmrLockStats[1];
+}
 
-    FreeTmrCount--;
+// Function to clear the Lock Statistics
+// hold_start_ns is left alone as a Mutex may be held right now
+void RTOSTmrLockStatsReset(void)
+{
+	for (int i=0; i<2; i++){
+		__atomic_store_n(&RTOSTmrLockStats[i].acquired, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&RTOSTmrLockStats[i].contended, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&RTOSTmrLockStats[i].wait_ns, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&RTOSTmrLockStats[i].hold_ns, 0, __ATOMIC_RELAXED);
+	}
+}
 
-	// Unlock the Resources
-	pthread_mutex_unlock(&timer_pool_mutex);
+// Function to start walking the Timers for monitoring
+void RTOSTmrIterInit(RTOS_TMR_ITER *iter)
+{
+	iter->next_idx = 0;
+}
 
-	return timer_obj;
+// Function to read the next Timer in use, returns RTOS_FALSE once every Timer has been seen
+// No Mutex is taken, each record is copied and copied again if it changed meanwhile,
+// so a monitoring thread never holds up RTOSTmrStart(), RTOSTmrStop() or the Timer Task
+INT8U RTOSTmrIterNext(RTOS_TMR_ITER *iter, RTOS_TMR_INFO *info)
+{
+	RTOS_TMR *tmr;
+	INT32U seq;
+	INT32U tick;
+
+	while (iter->next_idx < RTOSTmrCtrl->RTOSTmrPoolSize) {
+		tmr = &RTOSTmrSlab[iter->next_idx];
+
+		do {
+			// Wait out a change in progress, giving up the CPU in case the writer is not running
+			while ((seq = __atomic_load_n(&tmr->RTOSTmrSeq, __ATOMIC_ACQUIRE)) & 1)
+				sched_yield();
+
+			tick = __atomic_load_n(&RTOSTmrCtrl->RTOSTmrTickCtr, __ATOMIC_RELAXED);
+			info->RTOSTmrPtr = tmr;
+			info->RTOSTmrName = (RTOSTmrNameTbl != NULL) ? RTOSTmrNameTbl[iter->next_idx] : NULL;
+			info->RTOSTmrState = tmr->RTOSTmrState;
+			info->RTOSTmrPeriod = tmr->RTOSTmrPeriod;
+			info->RTOSTmrOpt = tmr->RTOSTmrOpt;
+			info->RTOSTmrPrio = tmr->RTOSTmrPrio;
+			info->RTOSTmrStrikes = tmr->RTOSTmrStrikes;
+			info->RTOSTmrRemain = 0;
+			if (info->RTOSTmrState == RTOS_TMR_STATE_RUNNING && !RTOS_TMR_TICK_REACHED(tmr->RTOSTmrMatch, tick))
+				info->RTOSTmrRemain = tmr->RTOSTmrMatch - tick;
+
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		} while (__atomic_load_n(&tmr->RTOSTmrSeq, __ATOMIC_RELAXED) != seq);
+
+		iter->next_idx++;
+		if (info->RTOSTmrState != RTOS_TMR_STATE_UNUSED)
+			return RTOS_TRUE;
+	}
+
+	return RTOS_FALSE;
 }
 
-// Free the allocated timer object and put it back into free pool
-void free_timer_obj(RTOS_TMR *ptmr)
+// Hash a Timer name for the Name Index
+static INT32U name_hash(INT8 *name)
 {
-	// Lock the Resources
-	pthread_mutex_lock(&timer_pool_mutex);
+	INT32U hash = 2166136261u;
 
-	// Clear the Timer Fields
-	ptmr->RTOSTmrPeriod = 0;
-	ptmr->RTOSTmrDelay = 0;
+	while (*name)
+		hash = (hash ^ (INT8U)*name++) * 16777619u;
+	return hash;
+}
 
-	// Change the State
-	ptmr->RTOSTmrState = RTOS_TMR_STATE_UNUSED;
+// Function to turn on the Name Index used by RTOSTmrFindByName(), Timers that already have a name are added to it
+INT8U RTOSTmrNameIndexEnable(INT8U *perr)
+{
+	INT32U buckets = 1;
+	INT32U *bucket;
+	INT32U *next;
+	INT32U i;
+
+	RTOS_MUTEX_LOCK(&name_index_mutex);
+
+	if (RTOSTmrNameBucket != NULL) {
+		RTOS_MUTEX_UNLOCK(&name_index_mutex);
+		*perr = RTOS_ERR_NONE;
+		return RTOS_TRUE;
+	}
+
+	// One bucket per Timer, rounded up to a power of two
+	while (buckets < RTOSTmrCtrl->RTOSTmrPoolSize)
+		buckets <<= 1;
+	bucket = malloc(buckets * sizeof(INT32U));
+	next = malloc(RTOSTmrCtrl->RTOSTmrPoolSize * sizeof(INT32U));
+	if (bucket == NULL || next == NULL) {
+		free(bucket);
+		free(next);
+		RTOS_MUTEX_UNLOCK(&name_index_mutex);
+		*perr = RTOS_MALLOC_ERR;
+		return RTOS_FALSE;
+	}
+	for (i=0; i<buckets; i++)
+		bucket[i] = RTOS_TMR_NIL;
+	for (i=0; i<RTOSTmrCtrl->RTOSTmrPoolSize; i++)
+		next[i] = RTOS_TMR_NAME_UNINDEXED;
+	RTOSTmrNameBuckets = buckets;
+	RTOSTmrNameNext = next;
+	RTOSTmrNameBucket = bucket;
+
+	// Index the names given so far before anyone else can use the index,
+	// a Timer being created meanwhile is skipped by its own insert_name_entry() if it is already in
+	for (i=0; i<RTOSTmrCtrl->RTOSTmrPoolSize && RTOSTmrNameTbl != NULL; i++) {
+		if (RTOSTmrNameTbl[i] != NULL && RTOSTmrSlab[i].RTOSTmrState != RTOS_TMR_STATE_UNUSED)
+			insert_name_entry(&RTOSTmrSlab[i]);
+	}
+
+	RTOS_MUTEX_UNLOCK(&name_index_mutex);
+
+	*perr = RTOS_ERR_NONE;
+	return RTOS_TRUE;
+}
+
+// Function to find a Timer by its name, needs the Name Index turned on with RTOSTmrNameIndexEnable()
+// Returns the Timer created most recently under that name if several share it
+RTOS_TMR* RTOSTmrFindByName(INT8 *name, INT8U *perr)
+{
+	RTOS_TMR *found = NULL;
+	INT32U idx;
+
+	// ERROR Checking
+	if (name == NULL) {
+		*perr = RTOS_ERR_TMR_INVALID;
+		return NULL;
+	}
+
+	RTOS_MUTEX_LOCK(&name_index_mutex);
+
+	if (RTOSTmrNameBucket != NULL) {
+		idx = RTOSTmrNameBucket[name_hash(name) & (RTOSTmrNameBuckets - 1)];
+		while (idx != RTOS_TMR_NIL) {
+			if (strcmp(RTOSTmrNameTbl[idx], name) == 0) {
+				found = &RTOSTmrSlab[idx];
+				break;
+			}
+			idx = RTOSTmrNameNext[idx];
+		}
+	}
+
+	RTOS_MUTEX_UNLOCK(&name_index_mutex);
+
+	*perr = (found != NULL) ? RTOS_ERR_NONE : RTOS_ERR_TMR_NOT_FOUND;
+	return found;
+}
+
+// Function to set up the Callback Watchdog
+// Callbacks running longer than threshold_us are reported to hook, or printed when hook is NULL, and earn their
+// Timer a strike. With strikes non zero, a Timer that has that many is dispatched from then on by a low priority
+// Quarantine Task rather than the Timer Task. A threshold of 0 turns the watchdog off
+INT8U RTOSTmrWatchdogSet(INT32U threshold_us, INT8U strikes, RTOS_TMR_WATCHDOG_HOOK hook, INT8U *perr)
+{
+	// ERROR Checking
+	if(threshold_us == 0 && strikes != 0){
+		*perr = RTOS_ERR_TMR_INVALID_OPT;
+		return RTOS_FALSE;
+	}
+
+	RTOS_MUTEX_LOCK(&watchdog_mutex);
+
+	// Start the Quarantine Task before any Timer can be sent to it
+	if (strikes != 0 && !quarantine_started) {
+		sem_init(&quarantine_sem, 0, 0);
+		if (pthread_create(&quarantine_thread, NULL, RTOSTmrQuarantineTask, NULL) != 0) {
+			sem_destroy(&quarantine_sem);
+			RTOS_MUTEX_UNLOCK(&watchdog_mutex);
+			*perr = RTOS_ERR_TMR_WATCHDOG;
+			return RTOS_FALSE;
+		}
+		quarantine_started = RTOS_TRUE;
+	}
+
+	RTOSTmrWatchdogHook = hook;
+	RTOSTmrWatchdogStrikes = strikes;
+	RTOSTmrWatchdogUsec = threshold_us;
+
+	RTOS_MUTEX_UNLOCK(&watchdog_mutex);
+
+	*perr = RTOS_ERR_NONE;
+	return RTOS_TRUE;
+}
+
+// Function to forgive the watchdog strikes of a Timer so it goes back to the Timer Task on its next expiry
+INT8U RTOSTmrStrikesClear(RTOS_TMR *ptmr, INT8U *perr)
+{
+	// ERROR Checking
+	if(ptmr == NULL) {
+		*perr = RTOS_ERR_TMR_INVALID;
+		return RTOS_FALSE;
+	}
+	if(ptmr->RTOSTmrType != RTOS_TMR_TYPE){
+		*perr = RTOS_ERR_TMR_INVALID_TYPE;
+		return RTOS_FALSE;
+	}
+	if(ptmr->RTOSTmrState == RTOS_TMR_STATE_UNUSED){
+		*perr = RTOS_ERR_TMR_INACTIVE;
+		return RTOS_FALSE;
+	}
+	*perr = RTOS_ERR_NONE;
+
+	// Lock the Resources
+	RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	RTOS_TMR_WRITE_BEGIN(ptmr);
+	ptmr->RTOSTmrStrikes = 0;
+	RTOS_TMR_WRITE_END(ptmr);
+
+	// Unlock the Resources
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	return RTOS_TRUE;
+}
+
+// Function to set the Dispatch Priority of a Timer
+INT8U RTOSTmrPrioSet(RTOS_TMR *ptmr, INT8U prio, INT8U *perr)
+{
+	// ERROR Checking
+	if(ptmr == NULL) {
+		*perr = RTOS_ERR_TMR_INVALID;
+		return RTOS_FALSE;
+	}
+	if(ptmr->RTOSTmrType != RTOS_TMR_TYPE){
+		*perr = RTOS_ERR_TMR_INVALID_TYPE;
+		return RTOS_FALSE;
+	}
+	if(ptmr->RTOSTmrState == RTOS_TMR_STATE_UNUSED){
+		*perr = RTOS_ERR_TMR_INACTIVE;
+		return RTOS_FALSE;
+	}
+	if(prio >= RTOS_TMR_PRIO_LEVELS){
+		*perr = RTOS_ERR_TMR_INVALID_PRIO;
+		return RTOS_FALSE;
+	}
+	*perr = RTOS_ERR_NONE;
+
+	// Lock the Resources
+	RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	RTOS_TMR_WRITE_BEGIN(ptmr);
+
+	// An expired Timer already waiting for dispatch moves to the tail of its new Ready Queue
+	if (ptmr->RTOSTmrQueue == RTOS_TMR_QUEUE_READY) {
+		remove_ready_entry(ptmr);
+		ptmr->RTOSTmrPrio = prio;
+		insert_ready_entry(ptmr);
+	}
+	else {
+		ptmr->RTOSTmrPrio = prio;
+	}
+
+	RTOS_TMR_WRITE_END(ptmr);
+
+	// Unlock the Resources
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	return RTOS_TRUE;
+}
+
+// Function to set what a Periodic Timer does with periods it missed while waiting for dispatch
+INT8U RTOSTmrOverrunSet(RTOS_TMR *ptmr, INT8U policy, INT8U *perr)
+{
+	// ERROR Checking
+	if(ptmr == NULL) {
+		*perr = RTOS_ERR_TMR_INVALID;
+		return RTOS_FALSE;
+	}
+	if(ptmr->RTOSTmrType != RTOS_TMR_TYPE){
+		*perr = RTOS_ERR_TMR_INVALID_TYPE;
+		return RTOS_FALSE;
+	}
+	if(ptmr->RTOSTmrState == RTOS_TMR_STATE_UNUSED){
+		*perr = RTOS_ERR_TMR_INACTIVE;
+		return RTOS_FALSE;
+	}
+	if(policy != RTOS_TMR_OVERRUN_BURST && policy != RTOS_TMR_OVERRUN_SKIP && policy != RTOS_TMR_OVERRUN_COALESCE){
+		*perr = RTOS_ERR_TMR_INVALID_OPT;
+		return RTOS_FALSE;
+	}
+	*perr = RTOS_ERR_NONE;
+
+	// Lock the Resources, rearm_periodic_timer() reads the policy under the same Mutex
+	RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	ptmr->RTOSTmrOverrun = policy;
+
+	// Unlock the Resources
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	return RTOS_TRUE;
+}
+
+// To Get the number of periods coalesced into the Callback currently running for a Timer
+INT32U RTOSTmrMissedGet(RTOS_TMR *ptmr, INT8U *perr)
+{
+	// ERROR Checking
+	if(ptmr == NULL) {
+		*perr = RTOS_ERR_TMR_INVALID;
+		return 0;
+	}
+	if(ptmr->RTOSTmrType != RTOS_TMR_TYPE){
+		*perr = RTOS_ERR_TMR_INVALID_TYPE;
+		return 0;
+	}
+	if(ptmr->RTOSTmrState == RTOS_TMR_STATE_UNUSED){
+		*perr = RTOS_ERR_TMR_INACTIVE;
+		return 0;
+	}
+	*perr = RTOS_ERR_NONE;
+
+	return ptmr->RTOSTmrMissed;
+}
+
+// Function to give a Callback Function a stable id, used in place of its address in Snapshot Files
+INT8U RTOSTmrCallbackRegister(INT32U callback_id, RTOS_TMR_CALLBACK callback, INT8U *perr)
+{
+	INT16U idx;
+
+	// ERROR Checking
+	if(callback == NULL || callback_id == 0){
+		*perr = RTOS_ERR_TMR_NO_CALLBACK;
+		return RTOS_FALSE;
+	}
+
+	idx = register_callback(callback);
+	if(idx == 0){
+		*perr = RTOS_ERR_TMR_CALLBACK_FULL;
+		return RTOS_FALSE;
+	}
+	*perr = RTOS_ERR_NONE;
+
+	RTOSTmrCallbackStableId[idx] = callback_id;
+
+	return RTOS_TRUE;
+}
+
+// Function to save every Timer in use to a Snapshot File
+// The Slab is copied a chunk at a time so the Timer Task is only held up for one chunk at once
+// Timers whose Callback has no stable id are left out
+// The file is written next to path and renamed over it once complete, a crash leaves the previous Snapshot in place
+INT32U RTOSTmrSnapshotSave(const char *path, INT8U *perr)
+{
+	RTOS_TMR_SNAP_HDR *hdr;
+	RTOS_TMR_SNAP_REC *rec;
+	RTOS_TMR *tmr;
+	size_t map_size;
+	INT32U count = 0;
+	INT32U skipped = 0;
+	INT32U i, end;
+	char *tmp_path;
+	char *dir_path;
+	int fd;
+
+	tmp_path = malloc(strlen(path) + sizeof(".tmp"));
+	if (tmp_path == NULL) {
+		*perr = RTOS_MALLOC_ERR;
+		return 0;
+	}
+	strcpy(tmp_path, path);
+	strcat(tmp_path, ".tmp");
+
+	fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		free(tmp_path);
+		*perr = RTOS_ERR_TMR_SNAP_IO;
+		return 0;
+	}
+
+	// Size the file for the whole pool, it is cut down to the Timers actually written at the end
+	map_size = sizeof(RTOS_TMR_SNAP_HDR) + (size_t)RTOSTmrCtrl->RTOSTmrPoolSize * sizeof(RTOS_TMR_SNAP_REC);
+	if (ftruncate(fd, map_size) != 0 ||
+	    (hdr = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+		close(fd);
+		unlink(tmp_path);
+		free(tmp_path);
+		*perr = RTOS_ERR_TMR_SNAP_IO;
+		return 0;
+	}
+	rec = (RTOS_TMR_SNAP_REC *)(hdr + 1);
+
+	for (i=0; i<RTOSTmrCtrl->RTOSTmrPoolSize; i=end) {
+		end = i + RTOS_CFG_TMR_SNAP_CHUNK;
+		if (end > RTOSTmrCtrl->RTOSTmrPoolSize)
+			end = RTOSTmrCtrl->RTOSTmrPoolSize;
+
+		// Lock the Resources
+		RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+		for (tmr=&RTOSTmrSlab[i]; tmr<&RTOSTmrSlab[end]; tmr++) {
+			if (tmr->RTOSTmrState == RTOS_TMR_STATE_UNUSED)
+				continue;
+			// Callback ids only mean something in the process owning the Timer
+			if (tmr->RTOSTmrOwner != RTOSTmrOwnerId) {
+				skipped++;
+				continue;
+			}
+			if (tmr->RTOSTmrCallbackId != 0 && RTOSTmrCallbackStableId[tmr->RTOSTmrCallbackId] == 0) {
+				skipped++;
+				continue;
+			}
+			rec[count].RTOSTmrArg = (INT64U)(unsigned long)tmr->RTOSTmrCallbackArg;
+			rec[count].RTOSTmrCallbackId = RTOSTmrCallbackStableId[tmr->RTOSTmrCallbackId];
+			rec[count].RTOSTmrMatch = tmr->RTOSTmrMatch;
+			rec[count].RTOSTmrDelay = tmr->RTOSTmrDelay;
+			rec[count].RTOSTmrPeriod = tmr->RTOSTmrPeriod;
+			rec[count].RTOSTmrOpt = tmr->RTOSTmrOpt;
+			rec[count].RTOSTmrState = tmr->RTOSTmrState;
+			// A Periodic Timer whose Callback is running would be armed again right after, save it that way
+			if (tmr->RTOSTmrState == RTOS_TMR_STATE_COMPLETED && tmr->RTOSTmrOpt == RTOS_TMR_PERIODIC) {
+				rec[count].RTOSTmrMatch = tmr->RTOSTmrMatch + tmr->RTOSTmrPeriod;
+				rec[count].RTOSTmrState = RTOS_TMR_STATE_RUNNING;
+			}
+			rec[count].RTOSTmrPrio = tmr->RTOSTmrPrio;
+			rec[count].RTOSTmrOverrun = tmr->RTOSTmrOverrun;
+			count++;
+		}
+
+		// Unlock the Resources
+		RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+	}
+
+	hdr->RTOSSnapMagic = RTOS_TMR_SNAP_MAGIC;
+	hdr->RTOSSnapVersion = RTOS_TMR_SNAP_VERSION;
+	hdr->RTOSSnapCount = count;
+	hdr->RTOSSnapTick = __atomic_load_n(&RTOSTmrCtrl->RTOSTmrTickCtr, __ATOMIC_RELAXED);
+
+	munmap(hdr, map_size);
+	if (ftruncate(fd, sizeof(RTOS_TMR_SNAP_HDR) + (size_t)count * sizeof(RTOS_TMR_SNAP_REC)) != 0 || fsync(fd) != 0) {
+		close(fd);
+		unlink(tmp_path);
+		free(tmp_path);
+		*perr = RTOS_ERR_TMR_SNAP_IO;
+		return 0;
+	}
+	close(fd);
+
+	// Replace the previous Snapshot in one step
+	if (rename(tmp_path, path) != 0) {
+		unlink(tmp_path);
+		free(tmp_path);
+		*perr = RTOS_ERR_TMR_SNAP_IO;
+		return 0;
+	}
+
+	// Make the rename itself durable
+	dir_path = dirname(tmp_path);
+	fd = open(dir_path, O_RDONLY | O_DIRECTORY);
+	if (fd >= 0) {
+		fsync(fd);
+		close(fd);
+	}
+	free(tmp_path);
+
+	*perr = (skipped > 0) ? RTOS_ERR_TMR_NO_CALLBACK : RTOS_ERR_NONE;
+	return count;
+}
+
+// Function to create and re-arm the Timers saved in a Snapshot File
+// Callbacks must be registered with RTOSTmrCallbackRegister() first, records with an unknown id are left out
+// Records with out of range fields are left out too and reported with RTOS_ERR_TMR_SNAP_FORMAT
+INT32U RTOSTmrSnapshotRestore(const char *path, INT8U *perr)
+{
+	RTOS_TMR_SNAP_HDR *hdr;
+	RTOS_TMR_SNAP_REC *rec;
+	RTOS_TMR *tmr;
+	struct stat st;
+	INT32U count = 0;
+	INT32U skipped = 0;
+	INT32U invalid = 0;
+	INT32U base_tick;
+	INT32U remain;
+	INT32U callback_id = 0;
+	INT16U callback_idx = 0;
+	INT32U i, j;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		*perr = RTOS_ERR_TMR_SNAP_IO;
+		return 0;
+	}
+	if (fstat(fd, &st) != 0 || st.st_size < sizeof(RTOS_TMR_SNAP_HDR)) {
+		close(fd);
+		*perr = RTOS_ERR_TMR_SNAP_FORMAT;
+		return 0;
+	}
+	hdr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (hdr == MAP_FAILED) {
+		*perr = RTOS_ERR_TMR_SNAP_IO;
+		return 0;
+	}
+	if (hdr->RTOSSnapMagic != RTOS_TMR_SNAP_MAGIC || hdr->RTOSSnapVersion != RTOS_TMR_SNAP_VERSION ||
+	    st.st_size < sizeof(RTOS_TMR_SNAP_HDR) + (size_t)hdr->RTOSSnapCount * sizeof(RTOS_TMR_SNAP_REC)) {
+		munmap(hdr, st.st_size);
+		*perr = RTOS_ERR_TMR_SNAP_FORMAT;
+		return 0;
+	}
+	rec = (RTOS_TMR_SNAP_REC *)(hdr + 1);
+	madvise(hdr, st.st_size, MADV_SEQUENTIAL);
+
+	*perr = RTOS_ERR_NONE;
+
+	// Lock the Resources, the whole file goes in with one pass over the records
+	RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	// Every deadline is re-armed against the Tick the restore started on
+	base_tick = RTOSTmrCtrl->RTOSTmrTickCtr;
+
+	for (i=0; i<hdr->RTOSSnapCount; i++, rec++) {
+		// Let the Timer Task run between chunks
+		if (i > 0 && i % RTOS_CFG_TMR_SNAP_CHUNK == 0) {
+			RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+			RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+		}
+
+		// Leave out records that could never have been saved from a valid Timer
+		if ((rec->RTOSTmrOpt != RTOS_TMR_ONE_SHOT && rec->RTOSTmrOpt != RTOS_TMR_PERIODIC) ||
+		    (rec->RTOSTmrOpt == RTOS_TMR_PERIODIC && rec->RTOSTmrPeriod == 0) ||
+		    rec->RTOSTmrPrio >= RTOS_TMR_PRIO_LEVELS ||
+		    rec->RTOSTmrOverrun < RTOS_TMR_OVERRUN_BURST || rec->RTOSTmrOverrun > RTOS_TMR_OVERRUN_COALESCE ||
+		    (rec->RTOSTmrState != RTOS_TMR_STATE_STOPPED && rec->RTOSTmrState != RTOS_TMR_STATE_RUNNING &&
+		     rec->RTOSTmrState != RTOS_TMR_STATE_COMPLETED)) {
+			invalid++;
+			continue;
+		}
+
+		// Look up the Callback, records for the same Callback usually come in runs
+		if (rec->RTOSTmrCallbackId != callback_id || i == 0) {
+			callback_id = rec->RTOSTmrCallbackId;
+			callback_idx = 0;
+			for (j=1; j<RTOSTmrCallbackCount && callback_id != 0; j++) {
+				if (RTOSTmrCallbackStableId[j] == callback_id) {
+					callback_idx = j;
+					break;
+				}
+			}
+		}
+		if (callback_id != 0 && callback_idx == 0) {
+			skipped++;
+			continue;
+		}
+
+		tmr = alloc_timer_obj();
+		if (tmr == NULL) {
+			*perr = RTOS_ERR_TMR_NON_AVAIL;
+			break;
+		}
+
+		RTOS_TMR_WRITE_BEGIN(tmr);
+		tmr->RTOSTmrType = RTOS_TMR_TYPE;
+		tmr->RTOSTmrCallbackId = callback_idx;
+		tmr->RTOSTmrCallbackArg = (void *)(unsigned long)rec->RTOSTmrArg;
+		tmr->RTOSTmrOwner = RTOSTmrOwnerId;
+		tmr->RTOSTmrDelay = rec->RTOSTmrDelay;
+		tmr->RTOSTmrPeriod = rec->RTOSTmrPeriod;
+		tmr->RTOSTmrOpt = rec->RTOSTmrOpt;
+		tmr->RTOSTmrPrio = rec->RTOSTmrPrio;
+		tmr->RTOSTmrOverrun = rec->RTOSTmrOverrun;
+		tmr->RTOSTmrMissed = 0;
+		tmr->RTOSTmrStrikes = 0;
+		tmr->RTOSTmrNext = RTOS_TMR_NIL;
+		tmr->RTOSTmrPrev = RTOS_TMR_NIL;
+		tmr->RTOSTmrQueue = RTOS_TMR_QUEUE_NONE;
+		tmr->RTOSTmrState = rec->RTOSTmrState;
+		// Keep the time that was left when the Snapshot finished, a deadline already passed by then is due now
+		remain = 0;
+		if (!RTOS_TMR_TICK_REACHED(rec->RTOSTmrMatch, hdr->RTOSSnapTick))
+			remain = rec->RTOSTmrMatch - hdr->RTOSSnapTick;
+		tmr->RTOSTmrMatch = base_tick + remain;
+		RTOS_TMR_WRITE_END(tmr);
+
+		// Running Timers go back in the Hash Table, ones that are already due go straight to their Ready Queue
+		if (tmr->RTOSTmrState == RTOS_TMR_STATE_RUNNING) {
+			if (RTOS_TMR_TICK_REACHED(tmr->RTOSTmrMatch, RTOSTmrCtrl->RTOSTmrTickCtr))
+				insert_ready_entry(tmr);
+			else
+				insert_hash_entry(tmr);
+		}
+		count++;
+	}
+
+	// Unlock the Resources
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	munmap(hdr, st.st_size);
+
+	if (*perr == RTOS_ERR_NONE && invalid > 0)
+		*perr = RTOS_ERR_TMR_SNAP_FORMAT;
+	else if (*perr == RTOS_ERR_NONE && skipped > 0)
+		*perr = RTOS_ERR_TMR_NO_CALLBACK;
+	return count;
+}
+
+// Function to set the Per-Tick Budget for Callbacks
+// Expiries of Priorities below RTOS_TMR_PRIO_HIGH beyond the budget are deferred to the following Ticks
+INT8U RTOSTmrBudgetSet(INT8U mode, INT32U limit, INT8U *perr)
+{
+	// ERROR Checking
+	if(mode != RTOS_TMR_BUDGET_NONE && mode != RTOS_TMR_BUDGET_COUNT && mode != RTOS_TMR_BUDGET_USEC){
+		*perr = RTOS_ERR_TMR_INVALID_OPT;
+		return RTOS_FALSE;
+	}
+	if(mode != RTOS_TMR_BUDGET_NONE && limit == 0){
+		*perr = RTOS_ERR_TMR_INVALID_BUDGET;
+		return RTOS_FALSE;
+	}
+	*perr = RTOS_ERR_NONE;
+
+	// Lock the Resources
+	RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	RTOSTmrCtrl->RTOSTmrBudgetMode = mode;
+	RTOSTmrCtrl->RTOSTmrBudgetLimit = limit;
+
+	// Unlock the Resources
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	return RTOS_TRUE;
+}
+
+// Function to get a copy of the Expiry Statistics
+void RTOSTmrStatsGet(RTOS_TMR_STATS *stats)
+{
+	// Lock the Resources
+	RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	*stats = RTOSTmrCtrl->RTOSTmrStats;
+
+	// Unlock the Resources
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+}
+
+/*****************************************************
+ * Internal Functions
+ *****************************************************
+ */
+
+// Create Pool of Timers
+INT8U Create_Timer_Pool(INT32U timer_count)
+{
+	// Create the Timer pool as one Slab, the free list links the records by index
+	// A Shared Memory Timer Service has already placed the Slab in its segment
+	if (RTOSTmrShmBase == NULL)
+		RTOSTmrSlab = calloc(timer_count, sizeof(RTOS_TMR));
+	if (timer_count > 0 && RTOSTmrSlab == NULL)
+		return RTOS_MALLOC_ERR;
+
+	RTOSTmrCtrl->RTOSTmrPoolSize = timer_count;
+	RTOSTmrCtrl->FreeTmrCount = timer_count;
+	RTOSTmrCtrl->FreeTmrListIdx = RTOS_TMR_NIL;
+
+	// Build the free list backwards so the first allocation gets index 0
+	for (INT32U i=timer_count; i-- > 0; ){
+		RTOS_TMR *tmr = &RTOSTmrSlab[i];
+		tmr->RTOSTmrType = RTOS_TMR_TYPE;
+		tmr->RTOSTmrCallbackId = 0;
+		tmr->RTOSTmrCallbackArg = NULL;
+		tmr->RTOSTmrOwner = RTOS_TMR_OWNER_SERVICE;
+		tmr->RTOSTmrMatch = 0;
+		tmr->RTOSTmrDelay = 0;
+		tmr->RTOSTmrPeriod = 0;
+		tmr->RTOSTmrOpt = 0;
+		tmr->RTOSTmrPrio = RTOS_TMR_PRIO_NORMAL;
+		tmr->RTOSTmrOverrun = RTOS_TMR_OVERRUN_SKIP;
+		tmr->RTOSTmrMissed = 0;
+		tmr->RTOSTmrStrikes = 0;
+		tmr->RTOSTmrGen = 0;
+		tmr->RTOSTmrQueue = RTOS_TMR_QUEUE_NONE;
+		tmr->RTOSTmrState = RTOS_TMR_STATE_UNUSED;
+		tmr->RTOSTmrPrev = RTOS_TMR_NIL;
+		tmr->RTOSTmrNext = RTOSTmrCtrl->FreeTmrListIdx;
+		RTOSTmrCtrl->FreeTmrListIdx = i;
+	}
+
+	return RTOS_SUCCESS;
+}
+
+// Initialize the Hash Table
+void init_hash_table(void)
+{	
+	// Make sure everything is empty
+	for (int i=0; i<HASH_TABLE_SIZE; i++){
+		RTOSTmrCtrl->hash_table[i].timer_count = 0;
+		RTOSTmrCtrl->hash_table[i].list_idx = RTOS_TMR_NIL;
+		RTOSTmrCtrl->hash_table[i].tail_idx = RTOS_TMR_NIL;
+	}
+}
+
+// Initialize the Ready Queues and Expiry Statistics
+void init_ready_queues(void)
+{
+	for (int i=0; i<RTOS_TMR_PRIO_LEVELS; i++){
+		RTOSTmrCtrl->ready_queue[i].timer_count = 0;
+		RTOSTmrCtrl->ready_queue[i].head_idx = RTOS_TMR_NIL;
+		RTOSTmrCtrl->ready_queue[i].tail_idx = RTOS_TMR_NIL;
+	}
+	RTOSTmrCtrl->quarantine_queue.timer_count = 0;
+	RTOSTmrCtrl->quarantine_queue.head_idx = RTOS_TMR_NIL;
+	RTOSTmrCtrl->quarantine_queue.tail_idx = RTOS_TMR_NIL;
+	memset(&RTOSTmrCtrl->RTOSTmrStats, 0, sizeof(RTOSTmrCtrl->RTOSTmrStats));
+}
+
+// Insert a Timer Object in the Hash Table
+// Caller must hold hash_table_mutex
+void insert_hash_entry(RTOS_TMR *timer_obj)
+{
+	// Calculate the index using Hash Function
+	int idx = timer_obj->RTOSTmrMatch % HASH_TABLE_SIZE;
+
+	// Add the Entry
+	// Place timer at the end of the list so Timers with the same Match expire in the order they were started
+	// TmrTask will perform a linear search
+	timer_obj->RTOSTmrNext = RTOS_TMR_NIL;
+	timer_obj->RTOSTmrPrev = RTOSTmrCtrl->hash_table[idx].tail_idx;
+	if (RTOSTmrCtrl->hash_table[idx].tail_idx != RTOS_TMR_NIL)
+		RTOSTmrSlab[RTOSTmrCtrl->hash_table[idx].tail_idx].RTOSTmrNext = RTOS_TMR_IDX(timer_obj);
+	else
+		RTOSTmrCtrl->hash_table[idx].list_idx = RTOS_TMR_IDX(timer_obj);
+	RTOSTmrCtrl->hash_table[idx].tail_idx = RTOS_TMR_IDX(timer_obj);
+	RTOSTmrCtrl->hash_table[idx].timer_count++;
+
+	timer_obj->RTOSTmrQueue = RTOS_TMR_QUEUE_WHEEL;
+}
+
+// Remove the Timer Object entry from the Hash Table, or from its Ready Queue if it already expired
+// Caller must hold hash_table_mutex
+void remove_hash_entry(RTOS_TMR *timer_obj)
+{
+	// Nothing to do if the Timer is not on any list
+	if (timer_obj->RTOSTmrQueue == RTOS_TMR_QUEUE_NONE)
+		return;
+
+	if (timer_obj->RTOSTmrQueue == RTOS_TMR_QUEUE_READY || timer_obj->RTOSTmrQueue == RTOS_TMR_QUEUE_QUARANTINE) {
+		remove_ready_entry(timer_obj);
+		return;
+	}
+
+	// Calculate the index using Hash Function
+	int idx = timer_obj->RTOSTmrMatch % HASH_TABLE_SIZE;
+
+	// Remove the Timer Obj
+	if (timer_obj->RTOSTmrPrev != RTOS_TMR_NIL)
+		RTOSTmrSlab[timer_obj->RTOSTmrPrev].RTOSTmrNext = timer_obj->RTOSTmrNext;
+	else
+		RTOSTmrCtrl->hash_table[idx].list_idx = timer_obj->RTOSTmrNext;
+	if (timer_obj->RTOSTmrNext != RTOS_TMR_NIL)
+		RTOSTmrSlab[timer_obj->RTOSTmrNext].RTOSTmrPrev = timer_obj->RTOSTmrPrev;
+	else
+		RTOSTmrCtrl->hash_table[idx].tail_idx = timer_obj->RTOSTmrPrev;
+	RTOSTmrCtrl->hash_table[idx].timer_count--;
+
+	timer_obj->RTOSTmrNext = RTOS_TMR_NIL;
+	timer_obj->RTOSTmrPrev = RTOS_TMR_NIL;
+	timer_obj->RTOSTmrQueue = RTOS_TMR_QUEUE_NONE;
+}
+
+// Append an expired Timer Object to the tail of the Ready Queue of its Priority
+// Timers the Callback Watchdog caught too often go to the Quarantine Queue instead
+// Caller must hold hash_table_mutex
+void insert_ready_entry(RTOS_TMR *timer_obj)
+{
+	READY_OBJ *queue = &RTOSTmrCtrl->ready_queue[timer_obj->RTOSTmrPrio];
+	INT8U quarantine = RTOSTmrWatchdogStrikes != 0 && timer_obj->RTOSTmrStrikes >= RTOSTmrWatchdogStrikes;
+
+	if (quarantine)
+		queue = &RTOSTmrCtrl->quarantine_queue;
+
+	timer_obj->RTOSTmrNext = RTOS_TMR_NIL;
+	timer_obj->RTOSTmrPrev = queue->tail_idx;
+	if (queue->tail_idx != RTOS_TMR_NIL)
+		RTOSTmrSlab[queue->tail_idx].RTOSTmrNext = RTOS_TMR_IDX(timer_obj);
+	else
+		queue->head_idx = RTOS_TMR_IDX(timer_obj);
+	queue->tail_idx = RTOS_TMR_IDX(timer_obj);
+	queue->timer_count++;
+
+	if (quarantine) {
+		timer_obj->RTOSTmrQueue = RTOS_TMR_QUEUE_QUARANTINE;
+		RTOSTmrCtrl->RTOSTmrStats.RTOSTmrQuarantined++;
+		sem_post(&quarantine_sem);
+	}
+	else {
+		timer_obj->RTOSTmrQueue = RTOS_TMR_QUEUE_READY;
+	}
+}
+
+// Remove a Timer Object from its Ready Queue
+// Caller must hold hash_table_mutex
+void remove_ready_entry(RTOS_TMR *timer_obj)
+{
+	READY_OBJ *queue = &RTOSTmrCtrl->ready_queue[timer_obj->RTOSTmrPrio];
+
+	if (timer_obj->RTOSTmrQueue == RTOS_TMR_QUEUE_QUARANTINE)
+		queue = &RTOSTmrCtrl->quarantine_queue;
+
+	if (timer_obj->RTOSTmrPrev != RTOS_TMR_NIL)
+		RTOSTmrSlab[timer_obj->RTOSTmrPrev].RTOSTmrNext = timer_obj->RTOSTmrNext;
+	else
+		queue->head_idx = timer_obj->RTOSTmrNext;
+	if (timer_obj->RTOSTmrNext != RTOS_TMR_NIL)
+		RTOSTmrSlab[timer_obj->RTOSTmrNext].RTOSTmrPrev = timer_obj->RTOSTmrPrev;
+	else
+		queue->tail_idx = timer_obj->RTOSTmrPrev;
+	queue->timer_count--;
+
+	timer_obj->RTOSTmrNext = RTOS_TMR_NIL;
+	timer_obj->RTOSTmrPrev = RTOS_TMR_NIL;
+	timer_obj->RTOSTmrQueue = RTOS_TMR_QUEUE_NONE;
+}
+
+// Move every Timer of the current Tick's Hash Table entry that reached its Match to the Ready Queues
+// Returns the number of Timers that expired
+// Caller must hold hash_table_mutex
+INT32U expire_hash_entries(void)
+{
+	INT32U expired = 0;
+
+	// Check the whole List associated with the index of the Hash Table
+	int idx = RTOSTmrCtrl->RTOSTmrTickCtr % HASH_TABLE_SIZE;
+	RTOS_TMR *tmr = RTOS_TMR_PTR(RTOSTmrCtrl->hash_table[idx].list_idx);
+	RTOS_TMR *next;
+
+	while (tmr != NULL) {
+		next = RTOS_TMR_PTR(tmr->RTOSTmrNext);
+		if (RTOS_TMR_TICK_REACHED(tmr->RTOSTmrMatch, RTOSTmrCtrl->RTOSTmrTickCtr)) {
+			remove_hash_entry(tmr);
+			insert_ready_entry(tmr);
+			expired++;
+		}
+		tmr = next;
+	}
+
+	return expired;
+}
+
+// Check whether the Per-Tick Budget is used up
+static INT8U budget_exhausted(INT32U dispatched, struct timespec *start)
+{
+	struct timespec now;
+	INT64U elapsed_us;
+
+	if (RTOSTmrCtrl->RTOSTmrBudgetMode == RTOS_TMR_BUDGET_COUNT)
+		return dispatched >= RTOSTmrCtrl->RTOSTmrBudgetLimit;
+
+	if (RTOSTmrCtrl->RTOSTmrBudgetMode == RTOS_TMR_BUDGET_USEC) {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		elapsed_us = (INT64U)(now.tv_sec - start->tv_sec) * 1000000 + (now.tv_nsec - start->tv_nsec) / 1000;
+		return elapsed_us >= RTOSTmrCtrl->RTOSTmrBudgetLimit;
+	}
+
+	return RTOS_FALSE;
+}
+
+// Run the Callbacks of expired Timers, highest Priority first and FIFO within a Priority
+// Once the budget is used up, the remaining lower Priority expiries stay queued for the next Tick
+void dispatch_ready_timers(void)
+{
+	RTOS_TMR *tmr;
+	INT32U dispatched = 0;
+	INT32U backlog = 0;
+	INT8U prio;
+	INT8U out_of_budget = RTOS_FALSE;
+	INT32U wake_mask = 0;
+	struct timespec start;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (prio = 0; prio < RTOS_TMR_PRIO_LEVELS && !out_of_budget; prio++) {
+		while (1) {
+			// High Priority Timers always run, the rest only while budget remains
+			if (prio != RTOS_TMR_PRIO_HIGH && budget_exhausted(dispatched, &start)) {
+				out_of_budget = RTOS_TRUE;
+				break;
+			}
+
+			// Lock the Resources
+			RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+			tmr = RTOS_TMR_PTR(RTOSTmrCtrl->ready_queue[prio].head_idx);
+			if (tmr == NULL) {
+				RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+				break;
+			}
+
+			// Releases the Resources
+			run_ready_timer(tmr, &wake_mask);
+			dispatched++;
+		}
+	}
+
+	// Lock the Resources
+	RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	for (prio = 0; prio < RTOS_TMR_PRIO_LEVELS; prio++)
+		backlog += RTOSTmrCtrl->ready_queue[prio].timer_count;
+	RTOSTmrCtrl->RTOSTmrStats.RTOSTmrBacklog = backlog;
+	if (backlog > 0)
+		RTOSTmrCtrl->RTOSTmrStats.RTOSTmrBudgetHits++;
+
+	// Unlock the Resources
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	// Wake the Shared Memory clients that got expiries, once per Tick rather than once per Timer
+	wake_shm_clients(wake_mask);
+}
+
+// Run the Callback of an expired Timer at the head of a Ready or Quarantine Queue, timing it for the watchdog
+// Caller must hold hash_table_mutex, it is released before the Callback runs and not held on return
+void run_ready_timer(RTOS_TMR *tmr, INT32U *wake_mask)
+{
+	RTOS_TMR_CALLBACK callback;
+	void *callback_arg;
+	INT32U lateness;
+	INT32U threshold_us = RTOSTmrWatchdogUsec;
+	INT32U elapsed_us = 0;
+	INT32U suppressed;
+	INT64U now_ns, last_ns;
+	INT16U gen;
+	INT8U same;
+	INT8U strikes = 0;
+	INT8U slow;
+	INT8 *name = NULL;
+	struct timespec start, end;
+
+	remove_ready_entry(tmr);
+	RTOS_TMR_WRITE_BEGIN(tmr);
+	tmr->RTOSTmrState = RTOS_TMR_STATE_COMPLETED;
+	RTOS_TMR_WRITE_END(tmr);
+
+	// Remember which Timer this is, the Callback may delete it and another thread reuse the record
+	gen = __atomic_load_n(&tmr->RTOSTmrGen, __ATOMIC_RELAXED);
+
+	// Account for expiries that had to wait past their deadline
+	lateness = RTOSTmrCtrl->RTOSTmrTickCtr - tmr->RTOSTmrMatch;
+	if (lateness > 0) {
+		RTOSTmrCtrl->RTOSTmrStats.RTOSTmrDeferred++;
+		RTOSTmrCtrl->RTOSTmrStats.RTOSTmrDeferredTicks += lateness;
+		if (lateness > RTOSTmrCtrl->RTOSTmrStats.RTOSTmrDeferredMax)
+			RTOSTmrCtrl->RTOSTmrStats.RTOSTmrDeferredMax = lateness;
+	}
+	// Periods that went by while waiting, only reported by the COALESCE policy
+	tmr->RTOSTmrMissed = 0;
+	if (tmr->RTOSTmrOpt == RTOS_TMR_PERIODIC && tmr->RTOSTmrOverrun == RTOS_TMR_OVERRUN_COALESCE)
+		tmr->RTOSTmrMissed = lateness / tmr->RTOSTmrPeriod;
+	callback = RTOSTmrCallbackTbl[tmr->RTOSTmrCallbackId];
+	callback_arg = tmr->RTOSTmrCallbackArg;
+
+	// Timers of Shared Memory clients are handed to the client, their Callback only exists there
+	if (tmr->RTOSTmrOwner != RTOSTmrOwnerId) {
+		if (post_shm_expiry(tmr))
+			*wake_mask |= 1 << (tmr->RTOSTmrOwner - 1);
+		callback = NULL;
+	}
+
+	// Keep the name for a watchdog report, the Callback may delete the Timer
+	if (threshold_us != 0 && RTOSTmrNameTbl != NULL)
+		name = RTOSTmrNameTbl[RTOS_TMR_IDX(tmr)];
+
+	// Unlock the Resources, the Callback may use the Timer APIs
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	if (callback != NULL) {
+		if (threshold_us != 0) {
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			callback(callback_arg);
+			clock_gettime(CLOCK_MONOTONIC, &end);
+			elapsed_us = (INT64U)(end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+		}
+		else {
+			callback(callback_arg);
+		}
+	}
+
+	// Nothing left to do for a One Shot Timer whose Callback kept within the threshold
+	slow = threshold_us != 0 && elapsed_us > threshold_us;
+	if (!slow && tmr->RTOSTmrOpt != RTOS_TMR_PERIODIC)
+		return;
+
+	// Lock the Resources
+	RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	// Still the same Timer unless it was freed meanwhile, restarting or stopping it from the Callback keeps it
+	same = __atomic_load_n(&tmr->RTOSTmrGen, __ATOMIC_RELAXED) == gen && tmr->RTOSTmrState != RTOS_TMR_STATE_UNUSED;
+
+	// Count a strike against the Timer
+	if (slow) {
+		RTOSTmrCtrl->RTOSTmrStats.RTOSTmrSlowCallbacks++;
+		if (same) {
+			RTOS_TMR_WRITE_BEGIN(tmr);
+			if (tmr->RTOSTmrStrikes < 255)
+				tmr->RTOSTmrStrikes++;
+			strikes = tmr->RTOSTmrStrikes;
+			RTOS_TMR_WRITE_END(tmr);
+		}
+	}
+
+	// Periodic Timers get armed again unless the Callback stopped, restarted or deleted them
+	if (same && tmr->RTOSTmrOpt == RTOS_TMR_PERIODIC && tmr->RTOSTmrState == RTOS_TMR_STATE_COMPLETED)
+		rearm_periodic_timer(tmr);
+
+	// Unlock the Resources
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	// Report the overrun, outside the Mutex as the hook may use the Timer APIs
+	if (slow && RTOSTmrWatchdogHook != NULL) {
+		RTOSTmrWatchdogHook(tmr, name, elapsed_us, strikes);
+	}
+	else if (slow) {
+		// Printing is kept to one line per RTOS_CFG_TMR_WATCHDOG_PRINT_NS so an overload does not add stdout I/O
+		// to every expiry, the other overruns are only counted
+		now_ns = (INT64U)end.tv_sec * 1000000000 + end.tv_nsec;
+		last_ns = __atomic_load_n(&RTOSTmrWatchdogPrintNs, __ATOMIC_RELAXED);
+		if (now_ns - last_ns >= RTOS_CFG_TMR_WATCHDOG_PRINT_NS &&
+		    __atomic_compare_exchange_n(&RTOSTmrWatchdogPrintNs, &last_ns, now_ns, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+			suppressed = __atomic_exchange_n(&RTOSTmrWatchdogSuppressed, 0, __ATOMIC_RELAXED);
+			fprintf(stdout, "Timer %s Callback ran for %u us, limit %u us, strike %u, %u more overruns not shown\n",
+				name != NULL ? name : "(unnamed)", elapsed_us, threshold_us, strikes, suppressed);
+		}
+		else {
+			__atomic_add_fetch(&RTOSTmrWatchdogSuppressed, 1, __ATOMIC_RELAXED);
+		}
+	}
+}
+
+// Wake the Shared Memory clients set in the mask
+void wake_shm_clients(INT32U wake_mask)
+{
+	INT32U client;
+
+	for (client = 0; wake_mask != 0; client++, wake_mask >>= 1) {
+		if (wake_mask & 1) {
+			__atomic_add_fetch(&RTOSTmrCtrl->shm_client[client].futex, 1, __ATOMIC_RELEASE);
+			syscall(SYS_futex, &RTOSTmrCtrl->shm_client[client].futex, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+		}
+	}
+}
+
+// Queue an expired Timer on the ring of the Shared Memory client owning it
+// Caller must hold hash_table_mutex
+INT8U post_shm_expiry(RTOS_TMR *timer_obj)
+{
+	SHM_CLIENT_OBJ *client;
+
+	if (timer_obj->RTOSTmrOwner == RTOS_TMR_OWNER_SERVICE || timer_obj->RTOSTmrOwner > RTOS_CFG_SHM_CLIENTS)
+		return RTOS_FALSE;
+	client = &RTOSTmrCtrl->shm_client[timer_obj->RTOSTmrOwner - 1];
+
+	if (!client->in_use)
+		return RTOS_FALSE;
+	if (client->tail - __atomic_load_n(&client->head, __ATOMIC_ACQUIRE) >= RTOS_CFG_SHM_RING) {
+		__atomic_store_n(&client->dropped, client->dropped + 1, __ATOMIC_RELAXED);
+		RTOSTmrCtrl->RTOSTmrStats.RTOSTmrShmDropped++;
+		return RTOS_FALSE;
+	}
+
+	client->ring[client->tail % RTOS_CFG_SHM_RING] = RTOS_TMR_IDX(timer_obj);
+	__atomic_store_n(&client->tail, client->tail + 1, __ATOMIC_RELEASE);
+
+	return RTOS_TRUE;
+}
+
+// Arm a Periodic Timer again from its previous deadline so lateness never turns into drift
+// Caller must hold hash_table_mutex
+void rearm_periodic_timer(RTOS_TMR *timer_obj)
+{
+	INT32U missed;
+
+	RTOS_TMR_WRITE_BEGIN(timer_obj);
+
+	timer_obj->RTOSTmrState = RTOS_TMR_STATE_RUNNING;
+	timer_obj->RTOSTmrMatch += timer_obj->RTOSTmrPeriod;
+
+	// Next deadline is still ahead, the usual case
+	if (!RTOS_TMR_TICK_REACHED(timer_obj->RTOSTmrMatch, RTOSTmrCtrl->RTOSTmrTickCtr)) {
+		insert_hash_entry(timer_obj);
+	}
+	// Next deadline already went by
+	else if (timer_obj->RTOSTmrOverrun == RTOS_TMR_OVERRUN_BURST) {
+		// Run again right away, still subject to the per-tick budget
+		insert_ready_entry(timer_obj);
+	}
+	else {
+		// SKIP and COALESCE jump to the first deadline after the current Tick on the original cadence
+		missed = (RTOSTmrCtrl->RTOSTmrTickCtr - timer_obj->RTOSTmrMatch) / timer_obj->RTOSTmrPeriod + 1;
+		timer_obj->RTOSTmrMatch += missed * timer_obj->RTOSTmrPeriod;
+		RTOSTmrCtrl->RTOSTmrStats.RTOSTmrSkipped += missed;
+		insert_hash_entry(timer_obj);
+	}
+
+	RTOS_TMR_WRITE_END(timer_obj);
+}
+
+// Run one Tick of the Timer Manager, shared by the Timer Task and the Virtual Clock
+// Returns the number of Timers that expired on the Tick
+INT32U process_tick(void)
+{
+	INT32U expired;
+
+	// Lock the Resources
+	RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	// Increment the Timer Tick Counter
+	RTOSTmrCtrl->RTOSTmrTickCtr++;
+
+	// Queue up the Timers that completed on this Tick
+	expired = expire_hash_entries();
+
+	// Unlock the Resources
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+	// Call their Callback Functions, Periodic Timers get inserted in the hash table again
+	dispatch_ready_timers();
+
+	return expired;
+}
+
+// Timer Task to Manage the Running Timers
+void *RTOSTmrTask(void *temp)
+{
+	while(1) {
+		// Wait for the signal from RTOSTmrSignal()
+		sem_wait(&timer_task_sem);
+
+		// Once got the signal, process the Tick
+		process_tick();
+	}
+	return temp;
+}
+
+// Quarantine Task to run the Callbacks of Timers the watchdog caught overrunning too often
+// It runs at the lowest nice level so those Callbacks never hold up the Timer Task
+void *RTOSTmrQuarantineTask(void *temp)
+{
+	RTOS_TMR *tmr;
+	INT32U wake_mask;
+
+	setpriority(PRIO_PROCESS, syscall(SYS_gettid), 19);
+
+	while(1) {
+		// Wait for insert_ready_entry() to queue something
+		sem_wait(&quarantine_sem);
+
+		wake_mask = 0;
+		while (1) {
+			// Lock the Resources
+			RTOS_MUTEX_LOCK(&RTOSTmrCtrl->hash_table_mutex);
+
+			tmr = RTOS_TMR_PTR(RTOSTmrCtrl->quarantine_queue.head_idx);
+			if (tmr == NULL) {
+				RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->hash_table_mutex);
+				break;
+			}
+
+			// Releases the Resources
+			run_ready_timer(tmr, &wake_mask);
+		}
+		wake_shm_clients(wake_mask);
+	}
+	return temp;
+}
+
+// Set up the Timer Pool, Hash Table, Ready Queues and Mutexes
+// pshared is PTHREAD_PROCESS_SHARED when the Control Block lives in a Shared Memory segment
+INT8U init_timer_engine(INT32U timer_count, int pshared)
+{
+	INT8U	retVal;
+	pthread_mutexattr_t mutex_attr;
+
+	// Create Timer Pool
+	retVal = Create_Timer_Pool(timer_count);
+
+	// Check the return Value
+	if (retVal != RTOS_SUCCESS)
+		return retVal;
+
+	// Init Hash Table
+	init_hash_table();
+	init_ready_queues();
+	memset(RTOSTmrCtrl->shm_client, 0, sizeof(RTOSTmrCtrl->shm_client));
+
+	RTOSTmrCtrl->RTOSTmrTickCtr = 0;
+	RTOSTmrCtrl->RTOSTmrBudgetMode = RTOS_TMR_BUDGET_NONE;
+	RTOSTmrCtrl->RTOSTmrBudgetLimit = 0;
+
+	// Initialize Mutex if any
+	pthread_mutexattr_init(&mutex_attr);
+	if (pthread_mutexattr_setpshared(&mutex_attr, pshared) != 0 ||
+	    pthread_mutex_init(&RTOSTmrCtrl->hash_table_mutex, &mutex_attr) != 0) {
+		pthread_mutexattr_destroy(&mutex_attr);
+		return RTOS_ERR_TMR_SHM;
+	}
+	if (pthread_mutex_init(&RTOSTmrCtrl->timer_pool_mutex, &mutex_attr) != 0) {
+		pthread_mutex_destroy(&RTOSTmrCtrl->hash_table_mutex);
+		pthread_mutexattr_destroy(&mutex_attr);
+		return RTOS_ERR_TMR_SHM;
+	}
+	pthread_mutexattr_destroy(&mutex_attr);
+
+	return RTOS_SUCCESS;
+}
+
+// Timer Initialization Function
+void RTOSTmrInit(void)
+{
+	INT32U timer_count = 0;
+	INT8U	retVal;
+	pthread_attr_t attr;
+
+	fprintf(stdout,"\n\nPlease Enter the number of Timers required in the Pool for the OS ");
+	scanf("%d", &timer_count);
+
+	// Create Timer Pool and Hash Table
+	retVal = init_timer_engine(timer_count, PTHREAD_PROCESS_PRIVATE);
+
+	// Check the return Value
+	if (retVal != RTOS_SUCCESS){
+		fprintf(stdout, "Error creating the timer pool\n");
+		return;
+	}
+
+	fprintf(stdout, "\n\nHash Table Initialized Successfully\n");
+
+	// Initialize Semaphore for Timer Task
+	sem_init(&timer_task_sem, 0, 0);
+
+	// Create any Thread if required for Timer Task
+	pthread_create(&thread, NULL, RTOSTmrTask, NULL);
+
+	fprintf(stdout,"\nRTOS Initialization Done...\n");
+}
+
+// Allocate a timer object from free timer pool
+RTOS_TMR* alloc_timer_obj(void)
+{
+	// Lock the Resources
+	RTOS_MUTEX_LOCK(&RTOSTmrCtrl->timer_pool_mutex);
+
+	// Check for Availability of Timers
+	if (RTOSTmrCtrl->FreeTmrCount == 0){
+		RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->timer_pool_mutex);
+		fprintf(stdout, "Failed to allocated timer object, no free timers\n");
+		return NULL;
+	}
+
+	// Assign the Timer Object
+	RTOS_TMR *timer_obj = &RTOSTmrSlab[RTOSTmrCtrl->FreeTmrListIdx];
+
+	RTOSTmrCtrl->FreeTmrListIdx = timer_obj->RTOSTmrNext;
+	timer_obj->RTOSTmrNext = RTOS_TMR_NIL;
+	__atomic_add_fetch(&timer_obj->RTOSTmrGen, 1, __ATOMIC_RELAXED);
+
+    RTOSTmrCtrl->FreeTmrCount--;
+
+	// Unlock the Resources
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->timer_pool_mutex);
+
+	return timer_obj;
+}
+
+// Look a Callback Function up in the Callback Hash
+// Returns its Callback Table index, or 0 with *slot set to the empty slot where it would go
+static INT16U find_callback(RTOS_TMR_CALLBACK callback, INT32U *slot)
+{
+	INT32U i = ((unsigned long)callback >> 4) * 2654435761u;
+	INT16U idx;
+
+	for (i &= RTOS_CFG_TMR_CALLBACK_HASH - 1; ; i = (i + 1) & (RTOS_CFG_TMR_CALLBACK_HASH - 1)) {
+		idx = __atomic_load_n(&RTOSTmrCallbackHash[i], __ATOMIC_ACQUIRE);
+		if (idx == 0 || RTOSTmrCallbackTbl[idx] == callback) {
+			*slot = i;
+			return idx;
+		}
+	}
+}
+
+// Find the Callback Table index of a Callback Function, adding it if it is new
+// Returns 0 for a NULL Callback or when the table is full
+INT16U register_callback(RTOS_TMR_CALLBACK callback)
+{
+	INT16U callback_id;
+	INT32U slot;
+
+	if (callback == NULL)
+		return 0;
+
+	// Callback Functions already in use are found without taking any Mutex
+	callback_id = find_callback(callback, &slot);
+	if (callback_id != 0)
+		return callback_id;
+
+	// Lock the Resources
+	RTOS_MUTEX_LOCK(&RTOSTmrCtrl->timer_pool_mutex);
+
+	// Another thread may have added it meanwhile
+	callback_id = find_callback(callback, &slot);
+	if (callback_id == 0 && RTOSTmrCallbackCount < RTOS_CFG_TMR_CALLBACKS){
+		callback_id = RTOSTmrCallbackCount;
+		RTOSTmrCallbackTbl[callback_id] = callback;
+		RTOSTmrCallbackCount++;
+		// Publish the slot once the Callback Table entry is in place
+		__atomic_store_n(&RTOSTmrCallbackHash[slot], callback_id, __ATOMIC_RELEASE);
+	}
+
+	// Unlock the Resources
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->timer_pool_mutex);
+
+	return callback_id;
+}
+
+// Add a named Timer Object to the Name Index, if the index is on and it is not in yet
+// Caller must hold name_index_mutex
+void insert_name_entry(RTOS_TMR *timer_obj)
+{
+	INT32U idx = RTOS_TMR_IDX(timer_obj);
+	INT32U bucket;
+
+	if (RTOSTmrNameBucket != NULL && RTOSTmrNameNext[idx] == RTOS_TMR_NAME_UNINDEXED &&
+	    RTOSTmrNameTbl != NULL && RTOSTmrNameTbl[idx] != NULL) {
+		bucket = name_hash(RTOSTmrNameTbl[idx]) & (RTOSTmrNameBuckets - 1);
+		RTOSTmrNameNext[idx] = RTOSTmrNameBucket[bucket];
+		RTOSTmrNameBucket[bucket] = idx;
+	}
+}
+
+// Remove a named Timer Object from the Name Index, if it is in
+// Caller must hold name_index_mutex
+void remove_name_entry(RTOS_TMR *timer_obj)
+{
+	INT32U idx = RTOS_TMR_IDX(timer_obj);
+	INT32U *link;
+
+	if (RTOSTmrNameBucket != NULL && RTOSTmrNameNext[idx] != RTOS_TMR_NAME_UNINDEXED) {
+		link = &RTOSTmrNameBucket[name_hash(RTOSTmrNameTbl[idx]) & (RTOSTmrNameBuckets - 1)];
+		while (*link != RTOS_TMR_NIL && *link != idx)
+			link = &RTOSTmrNameNext[*link];
+		if (*link == idx)
+			*link = RTOSTmrNameNext[idx];
+		RTOSTmrNameNext[idx] = RTOS_TMR_NAME_UNINDEXED;
+	}
+}
+
+// Free the allocated timer object and put it back into free pool
+void free_timer_obj(RTOS_TMR *ptmr)
+{
+	// Lock the Resources
+	RTOS_MUTEX_LOCK(&RTOSTmrCtrl->timer_pool_mutex);
+
+	RTOS_TMR_WRITE_BEGIN(ptmr);
+
+	// Clear the Timer Fields
+	ptmr->RTOSTmrPeriod = 0;
+	ptmr->RTOSTmrDelay = 0;
+
+	// Change the State
+	ptmr->RTOSTmrState = RTOS_TMR_STATE_UNUSED;
+	__atomic_add_fetch(&ptmr->RTOSTmrGen, 1, __ATOMIC_RELAXED);
+
+	// Drop the name from the Side Table
+	if (RTOSTmrNameTbl != NULL)
+		RTOSTmrNameTbl[RTOS_TMR_IDX(ptmr)] = NULL;
+
+	RTOS_TMR_WRITE_END(ptmr);
 
-	// Return the Timer to Free Timer Pool
-	ptmr->RTOSTmrNext = FreeTmrListPtr;
-	ptmr->RTOSTmrPrev = NULL; // timer will be placed at head of the list
-	FreeTmrListPtr->RTOSTmrPrev = ptmr;
-	FreeTmrListPtr = ptmr;
-	FreeTmrCount++;
+	// Return the Timer to Free Timer Pool, it will be placed at head of the list
+	ptmr->RTOSTmrNext = RTOSTmrCtrl->FreeTmrListIdx;
+	ptmr->RTOSTmrPrev = RTOS_TMR_NIL;
+	ptmr->RTOSTmrQueue = RTOS_TMR_QUEUE_NONE;
+	RTOSTmrCtrl->FreeTmrListIdx = RTOS_TMR_IDX(ptmr);
+	RTOSTmrCtrl->FreeTmrCount++;
 
 	// Unlock the Resources
-	pthread_mutex_unlock(&timer_pool_mutex);
+	RTOS_MUTEX_UNLOCK(&RTOSTmrCtrl->timer_pool_mutex);
 }
 
 // Function to Setup the Timer of Linux which will provide the Clock Tick Interrupt to the Timer Manager Module